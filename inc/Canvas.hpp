@@ -0,0 +1,46 @@
+#ifndef CANVAS_HPP
+#define CANVAS_HPP
+
+#include "Utility/Colour.hpp"
+#include <SFML/Graphics/Texture.hpp>
+#include <vector>
+
+/**
+ * A persistent RGBA pixel buffer that remembers which of its rows have changed. Only the changed rows 
+ * are refilled and uploaded each frame, so a static scene costs nothing to draw.
+ */
+class Canvas {
+private:
+    int width, height;
+    std::vector<Colour> pixels;
+
+    // The span [dirtyMin, dirtyMax) of each row that has changed. Rows with dirtyMin >= dirtyMax are clean.
+    std::vector<int> dirtyMin, dirtyMax;
+    // Non-zero for each row that has been written since the last upload.
+    std::vector<char> written;
+
+public:
+    Canvas(int _width, int _height);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+    Colour *Row(int y) { return &pixels[y * width]; }
+    // Writes a pixel and marks its row for upload. The pixel must be on the canvas.
+    void SetPixel(int x, int y, Colour colour);
+
+    // Marks the rect [xMin, xMax) x [yMin, yMax) as needing to be redrawn. The rect is clipped to the canvas.
+    void MarkDirty(int xMin, int yMin, int xMax, int yMax);
+    void MarkAll();
+
+    // Returns the span of row y that needs to be redrawn. Clears the row's span, as it is expected to be redrawn.
+    bool TakeDirtySpan(int y, int &xMin, int &xMax);
+    // Marks the rows [yMin, yMax) as written, so that they're included in the next upload.
+    void MarkWritten(int yMin, int yMax);
+
+    // Copies the written rows to the texture, which must have the same dimensions as the canvas. Nearby runs of 
+    // written rows are merged into a single upload. Returns the number of rows that were uploaded.
+    int Upload(sf::Texture &texture);
+};
+
+#endif
@@ -3,43 +3,176 @@
 
 #include "Constants.hpp"
 #include "Elements/Names.hpp"
-#include <SFML/Graphics/Color.hpp>
+#include "Utility/Colour.hpp"
 #include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 struct ElementProperties;
 struct ConstProperties;
 class ActionWorker;
+class Cells;
+class RoomCodec;
 
-struct CellState {
-    Element id;
-    float health            = 100.f;
-    sf::Vector2f velocity   = sf::Vector2f(0.f, 0.f);
+namespace impl {
 
-    uint64_t data           = 0; // Miscellaneous data to be used on a per-cell basis.
+    // A plane of per-cell values that is only allocated once a value is written. Until then every cell reads as the fallback.
+    template <typename T>
+    class LazyPlane {
+    private:
+        std::unique_ptr<T[]>    values;
+        std::atomic<T*>         plane {nullptr};
+        std::mutex              allocMutex;
+        size_t                  size;
+        T                       fallback;
 
-    CellState() : id(Element::air) {}
-    CellState(Element _id) : id(_id) {}
+    public:
+        LazyPlane(size_t _size, T _fallback) : size(_size), fallback(_fallback) {}
+
+        bool Allocated() const { return plane.load(std::memory_order_acquire) != nullptr; }
+        T Fallback() const { return fallback; }
+        T Get(size_t i) const {
+            T *p {plane.load(std::memory_order_acquire)};
+            return p ? p[i] : fallback;
+        }
+        T &Ref(size_t i) { return Allocate()[i]; }
+        // Resets the value of a cell without allocating the plane.
+        void Reset(size_t i) {
+            T *p {plane.load(std::memory_order_acquire)};
+            if (p) p[i] = fallback;
+        }
+
+        // Safe to call from several threads at once, as cells in different chunks may write at the same time.
+        T *Allocate() {
+            T *p {plane.load(std::memory_order_acquire)};
+            if (p) return p;
+
+            std::lock_guard<std::mutex> lock {allocMutex};
+            p = plane.load(std::memory_order_relaxed);
+            if (!p) {
+                values = std::make_unique<T[]>(size);
+                std::fill(values.get(), values.get() + size, fallback);
+                p = values.get();
+                plane.store(p, std::memory_order_release);
+            }
+            return p;
+        }
+    };
+
+    // Velocities are stored as 16-bit fixed point, which comfortably covers [-maxVelocity, maxVelocity].
+    struct PackedVelocity {
+        static constexpr float scale {32.f}; // Steps per cell/s.
+
+        int16_t x {0};
+        int16_t y {0};
+
+        static PackedVelocity Pack(sf::Vector2f v);
+        sf::Vector2f Unpack() const { return sf::Vector2f(x / scale, y / scale); }
+    };
+
+    //////// Proxies for the fields of a CellState ////////
+
+    class IdRef {
+    private:
+        const uint8_t *id;
+    public:
+        explicit IdRef(const uint8_t *_id) : id(_id) {}
+        operator Element() const { return static_cast<Element>(*id); }
+    };
+
+    class VelocityRef {
+    private:
+        PackedVelocity *velocity;
+    public:
+        explicit VelocityRef(PackedVelocity *_velocity) : velocity(_velocity) {}
+        operator sf::Vector2f() const { return velocity->Unpack(); }
+        VelocityRef &operator=(sf::Vector2f v) { *velocity = PackedVelocity::Pack(v); return *this; }
+        VelocityRef &operator+=(sf::Vector2f v) { return *this = velocity->Unpack() + v; }
+        // Compares the stored value, so values that only differ past the stored precision are equal.
+        bool operator==(sf::Vector2f v) const {
+            PackedVelocity packed {PackedVelocity::Pack(v)};
+            return velocity->x == packed.x && velocity->y == packed.y;
+        }
+        bool operator!=(sf::Vector2f v) const { return !(*this == v); }
+    };
+
+    template <typename T>
+    class LazyRef {
+    private:
+        LazyPlane<T>   *plane;
+        size_t          i;
+    public:
+        LazyRef(LazyPlane<T> *_plane, size_t _i) : plane(_plane), i(_i) {}
+        operator T() const { return plane->Get(i); }
+        LazyRef &operator=(T value) { plane->Ref(i) = value; return *this; }
+        LazyRef &operator+=(T value) { plane->Ref(i) += value; return *this; }
+        LazyRef &operator-=(T value) { plane->Ref(i) -= value; return *this; }
+    };
+
+}
+
+/**
+ * A handle to a single cell of a Cells grid. The fields of a cell are stored in separate planes, 
+ * so a CellState refers to them rather than holding them. Reads and writes go straight to the grid.
+ */
+class CellState {
+public:
+    impl::IdRef                 id;
+    impl::LazyRef<float>        health;
+    impl::VelocityRef           velocity;
+    impl::LazyRef<uint64_t>     data; // Miscellaneous data to be used on a per-cell basis.
+
+    CellState(Cells &cells, size_t i);
     void ApplyAcceleration(sf::Vector2f acc, float dt);
 };
 
 class Cells {
+    friend CellState;
+    friend RoomCodec;
 public:
-    std::vector<CellState> state;
-    std::vector<sf::Color> colour;
+    std::vector<Colour> colour;
 
 private:
+    // Cell fields, one value per cell. The id plane is the one that is queried most, so it's kept as small as possible.
+    std::vector<uint8_t>                ids;
+    std::vector<impl::PackedVelocity>   velocities;
+    // Most elements never touch their health or data, so these are only allocated when a cell writes to them.
+    impl::LazyPlane<float>              healths;
+    impl::LazyPlane<uint64_t>           datas;
+
+    // One bit per cell that is set when the cell isn't air. Each row is padded out to a whole number of words.
+    int width;
+    int rowWords;
+    std::vector<uint64_t> occupied;
+
     ElementProperties const *properties;
 
 public:
     Cells(int width, int height, const ElementProperties *_properties);
 
+    CellState At(size_t i) { return CellState(*this, i); }
+    Element Id(size_t i) const { return static_cast<Element>(ids[i]); }
+    // The occupancy of cells [64 * word, 64 * word + 64) of the given row, where bit n is set if that cell isn't air.
+    uint64_t OccupiedWord(int row, int word) const { return occupied[row * rowWords + word]; }
+
     //////// Assignment / manipulation functions ////////
-    void Assign(size_t i, Element id, sf::Color newColour);
+    void Assign(size_t i, Element id, Colour newColour);
     void Assign(size_t i, Element id, int x=0, int y=0);
+    // Swaps every field of cell i with cell j of another (or the same) grid.
+    void Swap(size_t i, Cells &other, size_t j);
 
     void Darken(size_t i);
 
+private:
+    void UpdateOccupied(size_t i);
+    // Recomputes the occupancy of every cell, after the id plane has been written to directly.
+    void RebuildOccupied();
+
+public:
     // Properties queries.
     const ConstProperties& GetProperties(int index) const;
     bool CanDisplace(Element self, Element other) const;
@@ -47,4 +180,4 @@ public:
     float Flammability(size_t i) const;
 };
 
-#endif
\ No newline at end of file
+#endif
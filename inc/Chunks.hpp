@@ -1,7 +1,11 @@
 #ifndef CHUNKS_HPP
 #define CHUNKS_HPP
 
+#include "Elements/Names.hpp"
 #include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 struct ChunkBounds {
@@ -17,23 +21,61 @@ enum ChunkState {
     AWAKE
 };
 
+// What a chunk has been doing, counted while the world's telemetry is enabled. The first counts are for the last step.
+struct ChunkActivity {
+    // A window is restless if the census changes by at most this fraction of the chunk's cells.
+    static constexpr float restlessFraction {0.01f};
+
+    uint32_t visited  {0};  // Occupied cells that were simulated.
+    uint32_t updated  {0};  // Cells that moved or acted.
+    uint32_t moves    {0};  // Moves queued by the chunk's cells.
+    uint32_t lost     {0};  // Moves into the chunk's cells that lost to another move into the same cell.
+    uint32_t actions  {0};  // Actions performed on the chunk's cells.
+    uint32_t awakeFor {0};  // The number of steps in a row that the chunk has been awake.
+
+    // Chunks that stay awake are judged over windows of steps, by comparing the number of cells of each element
+    // at either end of the window.
+    uint32_t windowSteps {0};
+    uint32_t census   [Element::count] {};  // At the start of the window.
+    uint32_t updatedBy[Element::count] {};  // The updates made by the cells of each element during the window.
+
+    // The windows where the chunk stayed awake without its census changing much.
+    uint32_t restlessWindows {0};
+    uint32_t longestAwake    {0};               // The longest awake streak seen at the end of a restless window.
+    uint32_t lastChange      {0};               // The change in the census over the last restless window.
+    Element  culprit         {Element::null};   // The element that made the most updates in the last restless window.
+
+    void ResetStep() { visited = updated = moves = 0; ResetConsolidation(); }
+    // Rooms can be sent requests without being stepped, so the counts made while consolidating are reset separately.
+    void ResetConsolidation() { lost = actions = 0; }
+};
+
 class Chunk {
 public:
+    // Only written while telemetry is enabled.
+    ChunkActivity activity;
+
     bool state;
-    bool nextState;
+    std::atomic<bool> nextState;
     int xMin, yMin,
         xMax, yMax;     // Dirty rect.
 private:
-    int xMinW, yMinW,
-        xMaxW, yMaxW;   // Working dirty rect.
+    // Working dirty rect. Atomic, as neighbouring chunks may be simulated on different threads.
+    std::atomic<int> xMinW, yMinW,
+                     xMaxW, yMaxW;
 public:
     Chunk();
 
     void Reset(ChunkBounds bounds);
     // Sets the state to AWAKE and updates the dirty-rect based on the given (x, y) coordinates.
+    // Safe to call from multiple threads at once.
     void KeepAlive(int x, int y, ChunkBounds bounds);
 
     void Update(ChunkBounds bounds);
+
+    // Returns the union of the current and working dirty rects. Between steps, this covers every cell that has 
+    // changed since the previous step. The width and height are not positive if nothing has changed.
+    ChunkBounds Changed() const;
 };
 
 class Chunks {
@@ -43,6 +85,13 @@ private:
     int chunkWidth,   chunkHeight; // Dimensions of an individual chunk.
     std::vector<Chunk> chunks;
 
+    // Bit i is set if chunk i is awake this step, or has been kept alive for the next one. Only the chunks in 
+    // either mask are updated, so asleep chunks cost nothing.
+    uint64_t              awake;
+    std::atomic<uint64_t> nextAwake;
+    // Called when the first chunk is kept alive for the next step.
+    std::function<void()> onWake;
+
 public:
     Chunks(int width, int height, int chunkWidth, int chunkHeight, int xOffset=0, int yOffset=0);
 
@@ -56,9 +105,16 @@ public:
     void KeepContainingAlive(int x, int y);
     // Sets the state of the neighboring chunk alive if (x, y) is on the border.
     void KeepNeighbourAlive(int x, int y);
+    // Keeps every cell of the chunk at the given index alive.
+    void Wake(int index);
+    // Sets the function that is called when the first chunk is kept alive after the chunks have been updated.
+    // May be called from any of the threads that keep chunks alive.
+    void SetWakeHandler(std::function<void()> handler);
 
     // Update functions.
     void UpdateChunk(int index);
+    // Updates every chunk that was awake or has been kept alive. Returns the mask of chunks that are now awake.
+    uint64_t Update();
 
     // Query functions.
     Chunk& GetChunk(int index);
@@ -68,6 +124,10 @@ public:
     bool IsActive(int index) const;
     bool IsActive(int x, int y) const;
     bool IsContainingActive(int x, int y) const;
+    // Returns true if no chunk is awake, or has been kept alive for the next step.
+    bool Asleep() const;
+    // Returns a mask with bit i set if chunk i is awake, or has been kept alive for the next step.
+    uint64_t AwakeMask() const;
 
     // Returns the coordinate of the chunk that contains the given (x, y) point.
     sf::Vector2i ContainingChunk(int x, int y) const;
@@ -75,6 +135,10 @@ public:
     // Returns the number of chunks.
     size_t Size() const;
 
+    // Returns the update phase [0, 4) of the chunk at the given index. Chunks that share a phase are never
+    // adjacent, so they can be simulated at the same time.
+    int Phase(int index) const;
+
     // Retrieving chunk boundaries.
     ChunkBounds GetBounds(int cx, int cy) const;
     ChunkBounds GetBounds(int index) const;
@@ -85,6 +149,9 @@ private:
     // Converts an (x, y) coordinate in world space to a chunk index.
     int Hash(int x, int y) const;
 
+    // Marks the chunk at the given index as kept alive for the next step.
+    void MarkAwake(int index);
+
     // Converts a chunk (x, y) index to a flat index.
     int ToIndex(int cx, int cy) const;
     // sf::Vector2i ToCoords(int index) const;
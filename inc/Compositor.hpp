@@ -0,0 +1,39 @@
+#ifndef COMPOSITOR_HPP
+#define COMPOSITOR_HPP
+
+#include "Canvas.hpp"
+#include "SandRoom.hpp"
+#include "Utility/JobSystem.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+
+// The visible portion [xMin, xMax) x [yMin, yMax) of a room, in world coordinates.
+struct RoomRegion {
+    SandRoom *room;
+    int xMin, xMax,
+        yMin, yMax;
+};
+
+/**
+ * Builds the picture of the visible world in a canvas. The cells are copied a row span at a time, with the rows 
+ * split across the job system, and the particles are drawn on top of them in a second pass.
+ */
+class Compositor {
+private:
+    Canvas &canvas;
+    // The canvas positions of the particles that were drawn last frame, which need their cells restored.
+    std::vector<sf::Vector2i> drawnParticles;
+
+public:
+    explicit Compositor(Canvas &_canvas);
+
+    // Redraws the dirty parts of the canvas from the given regions. The origin is the world position of the 
+    // canvas's first pixel.
+    void Compose(JobSystem &jobs, const std::vector<RoomRegion> &regions, sf::Vector2i origin);
+
+private:
+    void ComposeCells(JobSystem &jobs, const std::vector<RoomRegion> &regions, sf::Vector2i origin);
+    void ComposeParticles(const std::vector<RoomRegion> &regions, sf::Vector2i origin);
+};
+
+#endif
@@ -9,6 +9,9 @@ namespace constants {
     const int screenWidth   = 1024, screenHeight    = 512;
     const int numXChunks    = 8,    numYChunks      = 8;
     const int chunkWidth    = 64,   chunkHeight     = 64;
+    const int xMinRooms     = -2,   xMaxRooms       = 2;    // The default horizontal limits (number of rooms) of the world.
+    const int yMinRooms     = -1,   yMaxRooms       = 2;    // The default vertical limits of the world.
+    const int pageInRadius  = 2,    pageOutRadius   = 4;    // Distances (in rooms) from the view at which rooms are paged in and out.
 
     constexpr float maxVelocity     = 480.f;
     const sf::Vector2f accelGravity = {0.f, -60.f};
@@ -2,9 +2,11 @@
 #define ELEMENT_PROPERTIES_HPP
 
 #include "Elements/Names.hpp"
+#include "Utility/Colour.hpp"
 #include <cstdint>
-#include <SFML/Graphics/Color.hpp>
-#include <SFML/Graphics/Image.hpp>
+#include <functional>
+#include <limits>
+#include <SFML/System/Vector2.hpp>
 #include <string>
 #include <variant>
 #include <vector>
@@ -69,7 +71,7 @@ struct ColourProperties {
  * Contains information about how a given element is displayed when drawing.
  */
     bool colourEachFrame;
-    std::variant<std::vector<sf::Uint32>, sf::Image> palette;
+    std::variant<std::vector<uint32_t>, Texture> palette;
 
     ColourProperties() : colourEachFrame(false), palette() {}
 };
@@ -97,7 +99,13 @@ public:
     bool Insert(Element id, ConstProperties consts, ColourProperties palette, PaintProperties brush={});
 
     //////// Display functions ////////
-    sf::Color Colour(Element id, int x=0, int y=0) const;
+    ::Colour Colour(Element id, int x=0, int y=0) const;
+    // Returns the index of the colour within the element's palette, or -1 if it isn't in the palette. A textured 
+    // element has a single entry (0), which is the texture's colour at (x, y).
+    int PaletteIndex(Element id, ::Colour colour, int x, int y) const;
+    // Returns the colour at the given index of the element's palette. The inverse of PaletteIndex. Indices outside
+    // of the palette give a new colour for the element.
+    ::Colour PaletteColour(Element id, int index, int x, int y) const;
 
     //////// Simulation functions ////////
     // Returns true if the element represented by these properties can displace the element
@@ -106,11 +114,20 @@ public:
     bool CanDisplace(ElementType self, ElementType other) const;
 
 private:
-    sf::Color ColourFromArray(Element id) const;                    // Returns a colour, picked at random from the palette.
-    sf::Color ColourFromTexture(Element id, int x, int y) const;    // Returns a colour from a texture that corresponds to the supplied position.
+    ::Colour ColourFromArray(Element id) const;                     // Returns a colour, picked at random from the palette.
+    ::Colour ColourFromTexture(Element id, int x, int y) const;     // Returns a colour from a texture that corresponds to the supplied position.
     bool HasTexture(Element id) const;                              // Returns true if a texture is available for cells with these properties.
 
     bool Contains(Element id) const;
 };
 
+// Reads an image file into a texture. Returns true if successful, false otherwise.
+using TextureLoader = std::function<bool(const std::string &path, Texture &texture)>;
+// Sets how element textures are read. Decoding images is left to the front end, so the core doesn't need an image
+// library. Must be called before any world is created.
+void SetTextureLoader(TextureLoader loader);
+// Returns a palette that holds the texture at the given path, or just the fallback colour (0xRRGGBBAA) if there's
+// no loader or the texture can't be read. Textures only change how cells look, not how they behave.
+std::variant<std::vector<uint32_t>, Texture> TexturePalette(const std::string &path, uint32_t fallback);
+
 #endif
\ No newline at end of file
@@ -4,25 +4,58 @@
 #include "Cell.hpp"
 #include "Chunks.hpp"
 #include "Elements/Names.hpp"
+#include "Interactions/Blast.hpp"
+#include "Interactions/ConflictResolver.hpp"
 #include "Interactions/InteractionWorker.hpp"
 #include "Interactions/ParticleWorker.hpp"
 #include "SandRoom.hpp"
 #include "SandWorld.hpp"
+#include "Utility/RayTable.hpp"
+#include <cstdint>
 #include <vector>
-#include <unordered_set>
 
 class ActionWorker : public InteractionWorker {
-    using cached_points = std::unordered_set<sf::Vector2i, Vector2iHash>;
 private:
     ParticleWorker &particles;
     ElementProperties &properties;
     Cells &grid;
 
+    // The cells around an explosion that it has already visited, stamped with the generation of the explosion that
+    // last visited them. Starting a new explosion only takes a new generation, so nothing needs clearing.
+    struct ExplosionScratch {
+        // The explosion cells that went off this step.
+        std::vector<sf::Vector2i> detonations;
+
+        std::vector<uint32_t> cells;
+        std::vector<uint32_t> shockwave;
+        uint32_t generation {0};
+        int extent          {0};
+
+        void Resize(int extent);
+        void NextGeneration();
+        // Marks the cell at the given offset from the centre as visited. Returns false if it already was.
+        bool Visit(std::vector<uint32_t> &stamps, sf::Vector2i offset);
+    };
+    // One per job system thread, as explosions in different chunks may be simulated at the same time.
+    std::vector<ExplosionScratch> explosionScratch;
+
 public:
-    ActionWorker(roomID_t id, SandWorld &_world, SandRoom *_room, ParticleWorker &particles, float _dt);
+    // Detonations within this distance of a blast's first detonation are merged into it.
+    static constexpr int blastMergeReach {16};
+
+    ActionWorker(roomID_t id, SandWorld &_world, SandRoom *_room, ParticleWorker &particles);
+
+    // Makes sure that there is scratch storage for each of the given number of threads.
+    void ReserveScratch(int numThreads);
 
     bool PerformActions(sf::Vector2i p, CellState &cell, ConstProperties &constProp);
-    void ConsolidateActions();
+    // Performs one of the actions queued for each cell, chosen at random.
+    void ConsolidateActions(ConflictResolver &resolver);
+
+    // Adds the explosion cells that went off in the room this step to detonations.
+    void TakeDetonations(std::vector<sf::Vector2i> &detonations);
+    // Explodes outwards from the centre of a blast, queueing actions in the calling thread's outbox.
+    void Explode(const Blast &blast);
 
 private:
     bool ActOnSelf    (sf::Vector2i p, CellState &cell, ConstProperties &constProp);
@@ -45,8 +78,10 @@ private:
     bool ExplosionActOnOther(sf::Vector2i p, CellState &cell, ConstProperties &constProp);
 
     //////// Helpers for action functions ////////
-    // Creates an explosion path from pCentre to pRadius.
-    void ExplodeRadius(sf::Vector2i pCentre, sf::Vector2i pRadius, float force, cached_points &cachedCells, cached_points &cachedShockwave);
+    // Creates an explosion path from pCentre along one of the given table's rays. The first reach cells of the 
+    // path aren't dampened, as they lie among the blast's detonations.
+    void ExplodeRay(sf::Vector2i pCentre, const RayTable &rays, const RayTable::Ray &ray, float force, int reach, 
+        ExplosionScratch &scratch);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef INTERACTIONS_BLAST_HPP
+#define INTERACTIONS_BLAST_HPP
+
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+
+// A group of explosion cells that went off near each other in the same step, resolved as a single explosion.
+struct Blast {
+    sf::Vector2i origin;    // The first of the blast's detonations, which decides the room and chunk that it's resolved in.
+    sf::Vector2i centre;    // The mean position of the detonations.
+    int reach;              // The distance from the centre to the furthest detonation, rounded up.
+    int detonations;        // The number of explosion cells that were merged.
+};
+
+// Merges detonations into blasts. Each detonation joins the first blast whose origin is within maxReach of it,
+// so the reach of a blast never exceeds 2 * maxReach. Detonations are visited in order of position, so the same
+// detonations always give the same blasts, regardless of the order in which they're given.
+std::vector<Blast> MergeDetonations(std::vector<sf::Vector2i> detonations, int maxReach);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef INTERACTIONS_CONFLICT_RESOLVER_HPP
+#define INTERACTIONS_CONFLICT_RESOLVER_HPP
+
+#include "Utility/Random.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Picks one request at random for each destination cell out of a list of competing requests, in time linear in
+ * the number of requests. Each cell has a claim that holds the current winner and the number of requests for the
+ * cell so far. Every new request replaces the winner with a probability of 1 / count, so each request is equally 
+ * likely to win.
+ */
+class ConflictResolver {
+private:
+    static constexpr int        countBits   {8};
+    static constexpr uint32_t   countMask   {(1u << countBits) - 1};
+    // Requests past this point can't be stored in a claim, and are dropped.
+    static constexpr size_t     maxRequests {(1u << (32 - countBits)) - 1};
+
+    size_t numCells;
+    // ((winner + 1) << countBits) | count for each cell, or zero for cells without a request.
+    std::vector<uint32_t> claims;
+
+public:
+    // The claims are only allocated once there's something to resolve.
+    explicit ConflictResolver(size_t _numCells) : numCells(_numCells) {}
+
+    // Calls apply(request) for the winning request of each destination, in the order that they were requested. 
+    // dstOf(request) must return the request's destination cell index.
+    template <typename Request, typename DstFn, typename ApplyFn>
+    void Resolve(const std::vector<Request> &requests, DstFn dstOf, ApplyFn apply);
+};
+
+template <typename Request, typename DstFn, typename ApplyFn>
+void ConflictResolver::Resolve(const std::vector<Request> &requests, DstFn dstOf, ApplyFn apply) {
+    if (requests.empty()) return;
+    if (claims.empty()) claims.assign(numCells, 0);
+
+    const uint32_t numRequests {static_cast<uint32_t>(std::min(requests.size(), maxRequests))};
+    for (uint32_t i = 0; i < numRequests; ++i) {
+        uint32_t &claim {claims[dstOf(requests[i])]};
+        uint32_t count  {claim & countMask};
+        count += count < countMask; // The count saturates, after which later requests are slightly less likely to win.
+
+        if (count == 1 || QuickRandInt(count) == 0) {
+            claim = ((i + 1) << countBits) | count;
+        } else {
+            claim = (claim & ~countMask) | count;
+        }
+    }
+
+    // The claims are cleared as they're applied, so they're ready for the next frame.
+    for (uint32_t i = 0; i < numRequests; ++i) {
+        uint32_t &claim {claims[dstOf(requests[i])]};
+        if ((claim >> countBits) == i + 1) {
+            claim = 0;
+            apply(requests[i]);
+        }
+    }
+}
+
+#endif
@@ -3,19 +3,23 @@
 
 #include "Cell.hpp"
 #include "Chunks.hpp"
+#include "Interactions/Outbox.hpp"
 #include "SandRoom.hpp"
 #include "SandWorld.hpp"
 #include "Utility/Line.hpp"
 #include <SFML/System/Vector2.hpp>
+#include <algorithm>
 
 enum PathOpts : uint8_t {
     NO_OPTS = 0b0000,
-    SPAWN   = 0b0001, // Spawn new rooms as the path crosses them.
+    SPAWN   = 0b0001, // Request new rooms as the path reaches them.
     SKIP    = 0b0010, // Skip the starting point of the path.
 };
 
 // Helper functions used by all derived classes
-roomID_t BoolToID(roomID_t id, bool valid);
+inline roomID_t BoolToID(roomID_t id, bool valid) {
+    return (id * valid) + (valid - 1); // Should map (valid == true) -> id and (valid == false) -> -1.
+}
 
 class InteractionWorker {
 public:
@@ -26,15 +30,31 @@ public:
 protected:
     float dt;
 
+private:
+    // The outbox of the chunk that the calling thread is simulating.
+    static thread_local Outbox *outbox;
+
 public:
-    InteractionWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt);
+    InteractionWorker(roomID_t id, SandWorld &_world, SandRoom *_room);
+
+    // Sets the timestep for the coming frame.
+    void SetDt(float _dt) { dt = _dt; }
 
     void KeepContainingAlive(int x, int y);
     void KeepNeighbourAlive(int x, int y);
-protected:
 
-    CellState &GetCell(int x, int y);
-    CellState &GetCell(sf::Vector2i p);
+    // Sets the outbox that the calling thread's moves, actions and particles are queued in, until it is set again.
+    static void SetOutbox(Outbox *_outbox) { outbox = _outbox; }
+protected:
+    // Queues a move of the cell at src (in this room) into the cell at dst (in dstRoom). Both are in world coordinates.
+    void QueueMovement(SandRoom *dstRoom, sf::Vector2i src, sf::Vector2i dst);
+    // Queues the transformation of cell i of the given room into another element.
+    void QueueAction(SandRoom *dstRoom, size_t i, Element transform);
+    // Queues a particle to be added to the given room, pushed by the force F over its first step.
+    void QueueParticle(SandRoom *dstRoom, const Particle &particle, sf::Vector2f F);
+
+    CellState GetCell(int x, int y);
+    CellState GetCell(sf::Vector2i p);
     size_t CellIndex(sf::Vector2i);
     void SetCell(int x, int y, Element id);
 
@@ -80,13 +100,16 @@ std::pair<roomID_t, sf::Vector2i> InteractionWorker::PathEmpty(sf::Vector2i star
                 } else {
                     break;
                 }
+            } else if constexpr (Op & PathOpts::SPAWN) {
+                // The room is spawned once the phase is over, so every chunk sees the same rooms whatever order 
+                // they're simulated in. The path stops at the border until then, and its chunk stays awake to try again.
+                world.RequestRoom(check);
+                KeepContainingAlive(std::clamp(start.x, room->x, room->x + room->width  - 1),
+                                    std::clamp(start.y, room->y, room->y + room->height - 1));
+                break;
             } else {
                 dst = check;
-                if constexpr (Op & PathOpts::SPAWN) {
-                    validID = world.SpawnRoom(dst.x, dst.y);
-                } else {
-                    validID = checkID;
-                }
+                validID = checkID;
             }
         } else {
             break;
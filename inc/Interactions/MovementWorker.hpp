@@ -6,6 +6,7 @@
 #include "Chunks.hpp"
 #include "SandRoom.hpp"
 #include "SandWorld.hpp"
+#include "Interactions/ConflictResolver.hpp"
 #include "Interactions/InteractionWorker.hpp"
 #include <SFML/System/Vector2.hpp>
 #include <vector>
@@ -14,13 +15,25 @@ using roomID_t = int;
 
 class MovementWorker : public InteractionWorker {
     using IW = InteractionWorker;
+private:
+    // Winning moves whose source is in a neighbouring room. These touch two rooms, so they're held back until 
+    // every room has consolidated.
+    std::vector<Move> deferredMoves;
+
 public:
-    MovementWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt);
+    MovementWorker(roomID_t id, SandWorld &_world, SandRoom *_room);
 
     bool PerformMovement(sf::Vector2i p, CellState &cell, ConstProperties &prop);
-    void ConsolidateMovement();
+    // Performs one of the moves queued for each destination, chosen at random.
+    // Moves that come from another room are held back until ApplyDeferredMoves. Only touches this room, so 
+    // rooms can consolidate at the same time.
+    void ConsolidateMovement(ConflictResolver &resolver);
+    // Performs the moves into this room from its neighbours. Must not run at the same time as any other room's consolidation.
+    void ApplyDeferredMoves();
 
 private:
+    void ApplyMove(const Move &move);
+
     bool MoveCell   (sf::Vector2i p, CellState &cell, ConstProperties &constProp);
     bool SpreadCell (sf::Vector2i p, CellState &cell, ConstProperties &constProp);
 
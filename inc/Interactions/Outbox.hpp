@@ -0,0 +1,36 @@
+#ifndef INTERACTIONS_OUTBOX_HPP
+#define INTERACTIONS_OUTBOX_HPP
+
+#include "SandRoom.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+
+/**
+ * The moves, actions and particles that a chunk has queued during a step, split by the room that they're for. Requests only
+ * ever reach the neighbouring rooms, so there's a slot for the source room and each of its eight neighbours.
+ * After every chunk has been simulated, the world hands the outboxes over to the destination rooms.
+ */
+struct Outbox {
+    static constexpr int numSlots {SandRoom::numNeighbourSlots};
+
+    std::vector<Move>   moves   [numSlots];
+    std::vector<Action> actions [numSlots];
+    std::vector<Launch> launches[numSlots];
+
+    // Returns the slot for requests from the src room into the dst room. Matches the src room's neighbour slots.
+    static int Slot(const SandRoom &src, const SandRoom &dst) {
+        return SandRoom::NeighbourSlot((dst.x - src.x) / src.width, (dst.y - src.y) / src.height);
+    }
+
+    bool Empty(int slot) const {
+        return moves[slot].empty() && actions[slot].empty() && launches[slot].empty();
+    }
+
+    void Clear(int slot) {
+        moves[slot].clear();
+        actions[slot].clear();
+        launches[slot].clear();
+    }
+};
+
+#endif
@@ -3,20 +3,47 @@
 
 #include "Elements/Names.hpp"
 #include "Interactions/InteractionWorker.hpp"
-#include <SFML/Graphics/Color.hpp>
+#include "Utility/Colour.hpp"
 #include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
 
 class ParticleWorker : public InteractionWorker {
 private:
+    // A cell that a particle came to rest in.
+    struct Landing {
+        SandRoom       *room;
+        sf::Vector2i    p;
+    };
+    // A particle that ended its path in another room.
+    struct Migration {
+        size_t          index;
+        SandRoom       *room;
+    };
+
     ElementProperties &properties;
 
+    // Kept between steps to avoid reallocating them.
+    std::vector<sf::Vector2i>   oldPositions;   // The position of each particle before it was integrated.
+    std::vector<Landing>        landings;
+    std::vector<Migration>      migrations;
+    std::vector<uint8_t>        leaving;        // Whether each particle leaves the system at the end of the pass.
+    std::vector<Particle>       batch;
+
 public:
-    ParticleWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt);
+    ParticleWorker(roomID_t id, SandWorld &_world, SandRoom *_room);
 
-    void BecomeParticle(sf::Vector2i p, sf::Vector2f v, Element id, sf::Color colour);
-    void BecomeCell(size_t index);
+    void BecomeParticle(sf::Vector2i p, sf::Vector2f v, Element id, Colour colour);
 
     void ProcessParticles();
+
+private:
+    // Converts a particle into a cell in the grid. It leaves the system at the end of the pass.
+    void BecomeCell(size_t index, SandRoom *cellRoom, sf::Vector2i p);
+    // Wakes the chunks that particles landed in this pass.
+    void WakeLandings();
+    // Moves the particles that left the room into their new rooms, one batch per room.
+    void Migrate();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,50 +2,81 @@
 #define PARTICLES_HPP
 
 #include "Elements/Names.hpp"
-#include <SFML/Graphics/Color.hpp>
+#include "Utility/Colour.hpp"
 #include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+// A single particle, as it's handed to and from a particle system.
 struct Particle {
-public:
-    Element id = Element::null;
-    sf::Color colour;
-
-private:
+    Element      id = Element::null;
+    Colour       colour;
     sf::Vector2f p  = {0.f, 0.f};
     sf::Vector2f v  = {0.f, 0.f};
-    sf::Vector2f F  = {0.f, 0.f};
 
-public:
-    Particle(Element _id, sf::Vector2i _p, sf::Color _colour) : id(_id), p(_p), v(), F(), colour(_colour) {}
+    Particle(Element _id, sf::Vector2i _p, Colour _colour) : id(_id), colour(_colour), p(_p) {}
+};
 
-    // Returns the position of the particle (snapped to the grid).
-    sf::Vector2i Position() const;
-    // Sets the new position of the particle.
-    void Position(sf::Vector2i newP);
+// A particle that's pushed by a force over its first step.
+struct Launch {
+    Particle     particle;
+    sf::Vector2f F;
+};
 
-    // Launch the particle with a given initial force.
-    void ApplyForce(sf::Vector2f Fapplied={0.f, 0.f});
-    void Integrate(float dt);
+// How particles are moved forward in time.
+enum class Integrator {
+    EULER,  // Semi-implicit Euler: the velocity is updated first, then moves the particle.
+    VERLET  // Velocity Verlet, with the drag evaluated at the start and the middle of the step.
 };
 
+/**
+ * Holds particles as a structure of arrays, with one array per component, so that they can be integrated several
+ * at a time. The arrays are padded out to a whole number of lanes, and the padding is integrated along with the
+ * particles. Particles are removed in batches, which keeps the rest in order.
+ */
 class ParticleSystem {
-    std::vector<Particle> particles;
+public:
+    // The number of particles that are integrated together.
+    static constexpr size_t lanes {8};
+
+private:
+    std::vector<float>      px, py;     // Position.
+    std::vector<float>      vx, vy;     // Velocity.
+    std::vector<float>      Fx, Fy;     // The force applied over the next step, which is cleared after the step.
+    std::vector<Element>    ids;
+    std::vector<::Colour>   colours;
     size_t numParticles = 0;
 
 public:
     // Adds a particle with the given properties to the system.
-    void AddParticle(Particle &particle, sf::Vector2f Finit={0.f, 0.f});
+    void AddParticle(const Particle &particle, sf::Vector2f Finit={0.f, 0.f});
+    void AddParticles(const std::vector<Particle> &batch);
+    void AddParticles(const std::vector<Launch> &batch);
+
+    // Removes every particle whose flag is set. There must be a flag for each particle in Range().
+    void RemoveParticles(const std::vector<uint8_t> &removed);
 
-    // Removes a particle at a given index from the system.
-    void RemoveParticle(size_t index);
+    // Moves every particle forward by dt.
+    void Integrate(float dt, Integrator integrator=Integrator::EULER);
 
     // Returns the index range of the active particles.
     size_t Range() const;
 
     size_t Capacity() const;
 
-    Particle& operator[](size_t n);
+    // Access functions. The index must be less than Range().
+    Particle Get(size_t index) const;
+    Element Id(size_t index) const { return ids[index]; }
+    ::Colour Colour(size_t index) const { return colours[index]; }
+    // Returns the position of the particle (snapped to the grid).
+    sf::Vector2i Position(size_t index) const;
+    // Sets the new position of the particle.
+    void Position(size_t index, sf::Vector2i newP);
+
+private:
+    // Grows the arrays to hold at least the given number of particles.
+    void Reserve(size_t count);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,81 @@
+#ifndef RECORDING_HPP
+#define RECORDING_HPP
+
+#include "Elements/Names.hpp"
+#include "SandWorld.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A line of paint, with a square brush of the given radius stamped at every cell along it.
+struct Stroke {
+    uint64_t     tick;          // The step that the stroke was painted before, counted from the start of the session.
+    Element      brush;
+    int          radius;
+    sf::Vector2i start, end;    // World coordinates.
+};
+
+// Where the view was from a step on, until the next one. Rooms are spawned and paged around it before every step.
+struct Viewpoint {
+    uint64_t     tick;
+    sf::Vector2i centre, size;  // World coordinates.
+};
+
+/**
+ * A session of painting, which can be replayed to give the world the same work to do every time. Sessions start
+ * from an empty world and are stepped with a fixed dt. The view is kept, since it decides which rooms exist. Saved as plain text, one entry per line:
+ *
+ *      # Comments start with a hash.
+ *      seed <n>                                            # The seed that the random number generators start with.
+ *      dt <seconds>                                        # The length of every step.
+ *      ticks <n>                                           # The length of the session, in steps.
+ *      view <tick> <x> <y> <width> <height>                # The centre and size of the view.
+ *      stroke <tick> <element> <radius> <x0> <y0> <x1> <y1>
+ */
+class Recording {
+public:
+    uint64_t seed   {0};
+    float    dt     {1 / 60.f};
+    uint64_t ticks  {0};
+    std::vector<Viewpoint> views;   // In order of tick. Only recorded when the view moves.
+    std::vector<Stroke> strokes;    // In order of tick.
+
+    // Returns true if successful, false otherwise.
+    bool Save(const std::string &path, const ElementProperties &properties) const;
+    // Replaces the recording with the contents of the given file. Returns true if successful, false otherwise.
+    bool Load(const std::string &path, const ElementProperties &properties);
+
+    // Records the view for the given step, unless it's where it was last recorded.
+    void RecordView(uint64_t tick, sf::Vector2i centre, sf::Vector2i size);
+};
+
+// Paints a stroke into the world. The random numbers that painting draws only depend on the world's step and the
+// stroke, so replayed strokes paint the same cells.
+void PaintStroke(SandWorld &world, const Stroke &stroke);
+
+/**
+ * Plays a recording back into the world. Before every step the world follows the recorded view, and then the
+ * recorded strokes are painted, the same way that the game does while recording.
+ */
+class Replayer {
+private:
+    const Recording *recording  {nullptr};
+    size_t nextView             {0};
+    size_t nextStroke           {0};
+    const Viewpoint *view       {nullptr};
+
+public:
+    Replayer() = default;
+    explicit Replayer(const Recording &_recording) : recording(&_recording) {}
+
+    // Follows the view and paints the strokes for the upcoming step.
+    void Advance(SandWorld &world);
+
+    // Returns the view for the given step, or nullptr if none was recorded up to it.
+    const Viewpoint *ViewAt(uint64_t tick);
+    // Paints the strokes that were recorded before the given step.
+    void PaintStrokes(SandWorld &world);
+};
+
+#endif
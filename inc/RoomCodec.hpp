@@ -0,0 +1,40 @@
+#ifndef ROOM_CODEC_HPP
+#define ROOM_CODEC_HPP
+
+#include "SandRoom.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compresses the cells of a room so that it can be stored while it isn't loaded. Each chunk is encoded on its own,
+ * as runs of equal values per cell field. Colours are stored as an index into the element's palette where possible,
+ * which for textured elements is the same index for every cell that hasn't been recoloured.
+ * 
+ * An encoded room starts with a table of the offset and size of each chunk, so chunks can be found without decoding
+ * the ones before them. Only the cells are stored: the room's particles, queues and chunk states are not.
+ */
+class RoomCodec {
+public:
+    // Appends the encoded cells of one of the room's chunks to out.
+    static void EncodeChunk(const SandRoom &room, int chunk, std::vector<uint8_t> &out);
+    // Decodes a chunk that was written by EncodeChunk into the room. The room's cells must still be air. 
+    // Returns false if the data is malformed.
+    static bool DecodeChunk(SandRoom &room, int chunk, const uint8_t *data, size_t size);
+
+    // Encodes every chunk of the room, after a table of [number of chunks, (offset, size) of each chunk].
+    static std::vector<uint8_t> Encode(const SandRoom &room);
+    // Decodes a room that was written by Encode into a newly created room. Returns false if the data is malformed,
+    // in which case the room is left empty.
+    static bool Decode(SandRoom &room, const uint8_t *data, size_t size);
+    static bool Decode(SandRoom &room, const std::vector<uint8_t> &data);
+
+    // Recomputes the room's derived state, once all of its chunks have been decoded.
+    static void FinishDecode(SandRoom &room);
+
+private:
+    // Sets every cell of the room back to air.
+    static void Clear(SandRoom &room);
+};
+
+#endif
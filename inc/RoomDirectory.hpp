@@ -0,0 +1,65 @@
+#ifndef ROOM_DIRECTORY_HPP
+#define ROOM_DIRECTORY_HPP
+
+#include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using roomID_t = int;
+
+/**
+ * Maps room keys to room IDs. A world with a small, bounded area keeps a flat grid with one slot per room, so a 
+ * lookup is a bounds check and a load. Any other world uses an open-addressing table with linear probing, which 
+ * is kept at most half full so that most lookups only touch one slot.
+ * 
+ * Lookups in a dense directory may run at the same time as an insert or erase. Everything else must be guarded
+ * by the owner.
+ */
+class RoomDirectory {
+private:
+    // The largest number of rooms that is stored as a grid.
+    static constexpr int64_t maxDenseRooms {1 << 16};
+    static constexpr int     minCapacity   {64};
+
+    struct Slot {
+        uint64_t key;
+        roomID_t id;    // -1 when the slot is free.
+    };
+
+    const int xMin, yMin;
+    const int width, height;
+
+    // The grid of room IDs, indexed by [(y - yMin) * width + (x - xMin)]. Null if the directory is sparse.
+    std::unique_ptr<std::atomic<roomID_t>[]> grid;
+    // The hash table. The capacity is always a power of two.
+    std::vector<Slot> table;
+    size_t mask;
+
+    size_t count;
+
+public:
+    RoomDirectory(int _xMin, int _xMax, int _yMin, int _yMax);
+
+    // Returns the ID of the room with the given key, or -1 if there is none.
+    roomID_t Find(sf::Vector2i key) const;
+    // Sets the ID of the room with the given key.
+    void Insert(sf::Vector2i key, roomID_t id);
+    // Removes the room with the given key. Returns its ID, or -1 if there was none.
+    roomID_t Erase(sf::Vector2i key);
+
+    // True if the rooms are stored in a grid, which can be read without a lock.
+    bool Dense() const;
+    // Returns the number of rooms in the directory.
+    size_t Size() const;
+
+private:
+    // Returns the grid index of the key, or -1 if it lies outside of the grid.
+    int64_t GridIndex(sf::Vector2i key) const;
+    // Returns the slot holding the key, or the free slot where it would be inserted.
+    size_t Probe(uint64_t key) const;
+    void Grow();
+};
+
+#endif
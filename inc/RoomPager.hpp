@@ -0,0 +1,101 @@
+#ifndef ROOM_PAGER_HPP
+#define ROOM_PAGER_HPP
+
+#include "Utility/Hashes.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Keeps the encoded cells of rooms that have been paged out of the world, with one file per room. Files are 
+ * written and read on a background thread. A room's data stays in memory until its file has been written, and
+ * once it has been read back in, until the room is reloaded.
+ * 
+ * Every function may be called from any thread.
+ */
+class RoomPager {
+public:
+    using buffer_ptr = std::shared_ptr<const std::vector<uint8_t>>;
+
+private:
+    enum class State {
+        WRITING,    // The data is in memory and being written to disk.
+        STORED,     // The data is only on disk.
+        READING,    // The data is being read back from disk.
+        READY,      // The data has been read back into memory.
+        FAILED      // The file couldn't be read.
+    };
+
+    struct Entry {
+        State       state;
+        buffer_ptr  data;
+        uint64_t    generation; // Distinguishes the entries of a room that was paged out more than once.
+    };
+
+    struct Task {
+        enum Type { WRITE, READ, REMOVE } type;
+        sf::Vector2i    key;
+        uint64_t        generation;
+        buffer_ptr      data;
+    };
+
+    // The largest number of rooms that are kept in memory after being prefetched, before the oldest are dropped.
+    static constexpr size_t maxPrefetched {32};
+
+    const std::string directory;
+
+    mutable std::mutex                                      mutex;
+    std::condition_variable                                 taskReady;  // Signals the I/O thread.
+    std::condition_variable                                 taskDone;   // Signals threads waiting for a read.
+    std::unordered_map<sf::Vector2i, Entry, Vector2iHash>   entries;
+    std::deque<Task>                                        tasks;
+    std::deque<sf::Vector2i>                                prefetched;
+    uint64_t                                                nextGeneration {0};
+    bool                                                    stopping {false};
+
+    std::thread io;
+
+public:
+    // Stores the paged out rooms in the given directory, which is created if needed.
+    explicit RoomPager(std::string _directory);
+    // Finishes writing every room that has been paged out.
+    ~RoomPager();
+
+    RoomPager(const RoomPager&) = delete;
+    RoomPager& operator=(const RoomPager&) = delete;
+
+    // Takes the encoded cells of a room that is being paged out, to be written to disk in the background.
+    void Store(sf::Vector2i key, std::vector<uint8_t> data);
+    // Returns true if the room with the given key has been paged out.
+    bool Contains(sf::Vector2i key) const;
+    // Starts reading a paged out room back into memory, so that it's ready by the time it's loaded.
+    void Prefetch(sf::Vector2i key);
+    // Returns the encoded cells of a paged out room, waiting for them to be read if needed. Returns null if the 
+    // room hasn't been paged out or its file couldn't be read.
+    buffer_ptr Load(sf::Vector2i key);
+    // Forgets a room that has been loaded back into the world, and deletes its file.
+    void Forget(sf::Vector2i key);
+
+    // Returns the number of rooms that have been paged out.
+    size_t Size() const;
+    // Returns the keys of the rooms that have been paged out.
+    std::vector<sf::Vector2i> Keys() const;
+
+private:
+    void IoLoop();
+    std::string Path(sf::Vector2i key) const;
+
+    // Queues a task for the I/O thread. The lock must be held.
+    void Push(Task task);
+    // Drops the oldest prefetched rooms that were never loaded. The lock must be held.
+    void TrimPrefetched();
+};
+
+#endif
@@ -1,20 +1,23 @@
 #ifndef WORLD_STATE_HPP
 #define WORLD_STATE_HPP
 
+#include "Canvas.hpp"
 #include "Cell.hpp"
 #include "Chunks.hpp"
+#include "Compositor.hpp"
 #include "Elements/ElementProperties.hpp"
 #include "FreeList.h"
+#include "Recording.hpp"
 #include "SandWorld.hpp"
 #include "Screen.hpp"
+#include "Utility/Trace.hpp"
 #include <SFML/Graphics.hpp>
+#include <string>
 #include <vector>
 #include <utility>
 
 #define KEY_TO_NUMBER(x) (x - sf::Keyboard::Num0)
 
-class Lerp;
-
 enum MouseState {
     IDLE = 0,
     DRAWING,
@@ -35,46 +38,108 @@ struct Mouse {
     void Reset();
 };
 
+// The chunk counts that can be shown as a heatmap, cycled through with the H key.
+enum class Heatmap {
+    NONE = 0,
+    VISITED,
+    UPDATED,
+    MOVES,
+    LOST,
+    ACTIONS,
+    AWAKE,
+    count
+};
+
 class SandGame {
+    // Where the world is saved to with F5, and loaded from with F9.
+    static constexpr const char *quicksavePath {"./quicksave.sand"};
+    // Where traces are written to, and how many frames are captured when T is pressed.
+    static constexpr const char *tracePath {"./trace.json"};
+    static constexpr int traceFrames {120};
+    // The window that restless chunks are judged over when the heatmap turns telemetry on [steps].
+    static constexpr int defaultTelemetryWindow {300};
+
     SandWorld world;
     const int xMinRooms, xMaxRooms,
               yMinRooms, yMaxRooms;
 
     Screen      screen;
-    sf::Image   gridImage;
+    Canvas      canvas;         // The visible cells and particles. Only the parts that change are redrawn.
+    Compositor  compositor;
     sf::Texture gridTexture;
     sf::Sprite  gridSprite;
     // FPS display.
     sf::Font    font;
     sf::Text    text;
+    // The time taken by each stage of the frame, shown alongside the chunks in debug mode.
+    sf::Text    stageText;
+    // Where the frame-time histogram is written to when the game closes, unless it's empty.
+    std::string frameTimesPath;
+    Heatmap     heatmap {Heatmap::NONE};
 
     // Contains the room ID of each view corner. Will always be ordered BL -> BR -> TL -> TR.
     std::vector<std::pair<sf::Vector2i, roomID_t>> visibleRooms;
+    // The visible rooms from the last time the canvas was drawn.
+    std::vector<std::pair<sf::Vector2i, roomID_t>> drawnRooms;
+
+    // Recording and replaying sessions of painting. Sessions step with a fixed dt.
+    enum class SessionMode { NONE, RECORDING, REPLAYING };
+    SessionMode sessionMode {SessionMode::NONE};
+    Recording   session;
+    std::string recordPath;     // Where the session is saved to when the game closes.
+    Replayer    replayer;
+    std::vector<Stroke> pendingStrokes; // Painted this frame, once the view has been followed.
+    std::vector<float> stepTimes; // The time taken by each replayed step [milliseconds].
 
 public:
-    SandGame();
-    void Close() { screen.close(); }
+    // Rooms far from the view are paged out to the given directory, unless it's empty.
+    SandGame(int numThreads=1, const std::string &pageDirectory="", Integrator integrator=Integrator::EULER);
+    void Close();
     void Run();
 
+    // Records the painting done from now on, which is saved to the given path when the game closes.
+    void Record(const std::string &path);
+    // Replays the painting recorded in the given file, then reports the frame times and closes. Returns true if the
+    // recording was loaded, false otherwise.
+    bool Replay(const std::string &path);
+    // Writes the frame-time histogram to the given path when the game closes. See ExportFrameTimes.
+    void SaveFrameTimes(const std::string &path) { frameTimesPath = path; }
+    // Counts what each chunk does, and reports the chunks that stay awake for the given number of steps at a time
+    // without much changing when the game closes.
+    void TrackChunks(int window) { world.EnableTelemetry(window); }
+    // Captures a trace of the first given number of frames.
+    void Trace(int frames) { StartTrace(frames, tracePath); }
+
 private:
     void Step(float dt);
 
     // Game interaction
     void SetMouseState(Mouse &mouse, sf::Event &event, sf::Vector2i position);
+    // Queues a stroke from the mouse's last position to its current one.
     void Paint(Mouse &mouse);
-    void Paint(Lerp &stroke, Element type, int radius);
+    void Paint(const Stroke &stroke);
 
     // Moves the view based on the mouse state.
     void RepositionView(Mouse mouse);
+    // Keeps the FPS and stage text in the corner of the view.
+    void PlaceText();
 
+    // Marks the parts of the canvas that cover cells which changed during the last step.
+    void MarkChangedCells();
     // Draws visible area of the world to the screen.
     void Draw(Screen &screen);
     
+    // Returns the visible portion of each visible room.
+    std::vector<RoomRegion> VisibleRegions();
     // Updates the member vector (visibleRooms) that contains the IDs of each room that is currently visible in the view.
     void UpdateVisibleRooms();
 
     // DEBUGGING.
     void DrawChunks();
+    // Colours each chunk by the heatmap's count.
+    void DrawHeatmap();
+    // Updates the table of recent stage times.
+    void UpdateStageText();
 };
 
 #endif
\ No newline at end of file
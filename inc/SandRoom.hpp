@@ -7,6 +7,9 @@
 #include "Elements/ElementProperties.hpp"
 #include "FreeList.h"
 #include "Particles.hpp"
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <vector>
 #include <tuple>
 
@@ -14,19 +17,57 @@ using roomID_t = int;
 
 class MovementWorker;
 
-struct Move {
-    roomID_t srcRoomID;
-    int src;
-    int dst;
+// A queued move, packed into 32 bits. Holds the index of the destination in the room that the move was queued in, 
+// and the offset from the destination to the source, which may lie in a neighbouring room.
+class Move {
+public:
+    static constexpr int indexBits  {18};
+    static constexpr int offsetBits {7};
+
+private:
+    uint32_t bits;
 
-    Move() : srcRoomID(-1), src(-1), dst(-1) {}
-    Move(roomID_t _srcRoomID, int _src, int _dst) : srcRoomID(_srcRoomID), src(_src), dst(_dst) {}
+public:
+    Move(int dst, sf::Vector2i offset) : 
+        bits(static_cast<uint32_t>(dst) 
+            | static_cast<uint32_t>(offset.x + (1 << (offsetBits - 1))) << indexBits
+            | static_cast<uint32_t>(offset.y + (1 << (offsetBits - 1))) << (indexBits + offsetBits)) {}
+
+    int Dst() const { return bits & ((1u << indexBits) - 1); }
+    sf::Vector2i Offset() const {
+        constexpr uint32_t mask {(1u << offsetBits) - 1};
+        return sf::Vector2i(
+            static_cast<int>((bits >> indexBits) & mask) - (1 << (offsetBits - 1)),
+            static_cast<int>((bits >> (indexBits + offsetBits)) & mask) - (1 << (offsetBits - 1)));
+    }
+
+    // Returns true if a move with the given offset from destination to source can be stored.
+    static bool Fits(sf::Vector2i offset) {
+        constexpr int limit {1 << (offsetBits - 1)};
+        return offset.x >= -limit && offset.x < limit && offset.y >= -limit && offset.y < limit;
+    }
+};
+
+// A queued transformation of a cell into another element, packed into 32 bits.
+class Action {
+private:
+    uint32_t bits;
+
+public:
+    Action(size_t index, Element transform) : 
+        bits(static_cast<uint32_t>(index) | static_cast<uint32_t>(transform) << Move::indexBits) {}
+
+    size_t Index() const { return bits & ((1u << Move::indexBits) - 1); }
+    Element Transform() const { return static_cast<Element>(bits >> Move::indexBits); }
 };
 
 class SandRoom {
     friend MovementWorker;
     friend ActionWorker;
 public:
+    static constexpr int numNeighbourSlots {9};
+
+    roomID_t id;    // Set by the world once the room has been added to it.
     int x, y;
     int width, height;
 
@@ -38,19 +79,39 @@ public:
     ParticleSystem particles;
 
 private:
-    std::vector<Move> queuedMoves;
-    std::vector<std::pair<size_t, Element>> queuedActions;
+    std::vector<Move>   queuedMoves;
+    std::vector<Action> queuedActions;
+    // Guards the particle system, which may be written to by chunks that are simulated in parallel.
+    std::mutex particlesMutex;
+    // The rooms that surround this one, indexed by NeighbourSlot. The centre slot holds this room, and the slots
+    // of missing rooms are null. Kept up to date by the world as rooms are spawned and removed.
+    std::atomic<SandRoom*> neighbours[numNeighbourSlots];
+    // Set while the room is on the world's list of rooms to simulate next step.
+    std::atomic<bool> scheduled;
+    // Puts the room on the world's list. Set by the world once the room has been added to it.
+    std::function<void()> onSchedule;
 
 public:
     SandRoom(int _x, int _y, int _width, int _height, const ElementProperties * properties);
 
-    void QueueMovement(roomID_t srcRoomID, int pFrom, int pTo);
-    void QueueAction(size_t i, Element transform);
+    // Appends moves and actions from an outbox to the queues, to be consolidated at the end of the step.
+    void Enqueue(const std::vector<Move> &moves, const std::vector<Action> &actions);
+    // Adds particles that are already moving, or ones queued in an outbox. Takes the lock once for the whole batch.
+    void AddParticles(const std::vector<Particle> &batch);
+    void AddParticles(const std::vector<Launch> &batch);
+
+    // Scheduling.
+    void SetScheduleHandler(std::function<void()> handler);
+    // Makes sure that the room is simulated next step. Rooms schedule themselves as soon as a chunk is kept alive
+    // or a particle is added. May be called from multiple threads at once.
+    void Schedule();
+    // Called by the world as it takes the room off its list.
+    void Unschedule();
 
     // Access functions.
-    CellState& GetCell(int index);
-    CellState& GetCell(int x, int y);
-    CellState& GetCell(sf::Vector2i p);
+    CellState GetCell(int index);
+    CellState GetCell(int x, int y);
+    CellState GetCell(sf::Vector2i p);
 
     // Setting functions.
     void SetCell(int index, Element id);
@@ -62,6 +123,16 @@ public:
     bool InBounds(int _x, int _y) const;
     bool InBounds(sf::Vector2i p) const;
 
+    // Neighbouring rooms.
+    // Returns the slot of the neighbour that is dx rooms across and dy rooms up, where both are in [-1, 1].
+    static int NeighbourSlot(int dx, int dy) { return (dx + 1) + 3 * (dy + 1); }
+    SandRoom *Neighbour(int slot) const { return neighbours[slot].load(std::memory_order_acquire); }
+    void Link(int slot, SandRoom *neighbour) { neighbours[slot].store(neighbour, std::memory_order_release); }
+    // Returns true if the point lies within this room or one of its eight neighbours.
+    bool Adjacent(sf::Vector2i p) const;
+    // Returns the room that contains the point, which must be Adjacent. Null if there's no room there.
+    SandRoom *NeighbourContaining(sf::Vector2i p) const;
+
     // Helper functions.
     int ToIndex(int xw, int yw) const; // Converts world coordinates to a local index.
     int ToIndex(sf::Vector2i p) const;
@@ -15,23 +15,64 @@ class SandWorker {
 private:
     SandRoom* const room;
 
+    SandWorld &world;
     ElementProperties &properties;
 
+    // Picks the winners of the queued moves and actions. Shared by both, as they're consolidated one after the other.
+    ConflictResolver resolver;
+    // The active chunks of each update phase. Kept between frames to avoid reallocating them.
+    std::vector<int> phases[4];
+    // The moves and actions queued by each chunk during the step, indexed by chunk.
+    std::vector<Outbox> outboxes;
+
     ParticleWorker particles;
     MovementWorker movement;
     ActionWorker actions;
 
 public:
-    SandWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt);
+    // Workers are created and destroyed alongside their room.
+    SandWorker(roomID_t id, SandWorld &_world, SandRoom *_room);
+
+    SandRoom &Room() const { return *room; }
 
-    // Performs one iteration of the simulation.
-    void Step();
+    //////// The stages of a step, which the world runs across every room ////////
+    // Moves the particles and updates the chunks. Rooms must begin their steps one at a time.
+    void BeginStep(float dt);
+    // Returns the chunks of the given update phase [0, 4) that are active this step.
+    const std::vector<int> &ActiveChunks(int phase) const;
+    // Simulates a chunk, queueing its moves and actions in the chunk's outbox. Returns the number of cells that 
+    // were updated. Chunks that share a phase are never adjacent, so they may be simulated at the same time.
+    size_t SimulateChunk(int index);
+    // Adds the explosion cells that went off in the room this step to detonations.
+    void TakeDetonations(std::vector<sf::Vector2i> &detonations);
+    // Resolves a blast whose origin lies in this room. Its actions are queued in the outbox of the origin's chunk.
+    void ResolveBlast(const Blast &blast);
+    // The outbox of each chunk, which the world hands over to the destination rooms.
+    std::vector<Outbox> &Outboxes();
+    // Performs the moves and actions that were handed to the room. Rooms may consolidate at the same time.
+    void Consolidate();
+    // Performs the moves into this room from its neighbours. Rooms must finish their steps one at a time.
+    void FinishStep();
 
 private:
-    // Performs one step in the simulation of the given chunk.
-    void SimulateChunk(Chunk &chunk);
+    // Restarts the calling thread's random sequence on one that belongs to this room, step and stage, so that
+    // the room makes the same decisions whichever thread it's simulated on.
+    void SeedStream(uint64_t stream) const;
+    // Performs one step in the simulation of the given chunk. Returns the number of cells that were updated. The
+    // chunk's activity is counted unless it's null.
+    size_t SimulateChunkCells(Chunk &chunk, ChunkActivity *activity);
+    // The bits of the given occupancy word that fall within the room columns [xBegin, xEnd).
+    static uint64_t WordMask(int word, int xBegin, int xEnd);
+    // Applies the rules to a cell and keeps its surroundings awake if it did something. Returns true if it did.
+    bool SimulateCell(int x, int y, ChunkActivity *activity);
+
+    // Starts the activity counts of every chunk for a new step, given the chunks that are awake, and closes the 
+    // windows that have run for the given number of steps.
+    void UpdateActivity(uint64_t awake, int window);
+    // Counts the cells of each element in the given chunk.
+    void TakeCensus(int index, uint32_t (&census)[Element::count]) const;
 
-    // Returns true if the cell has performed some action.
+    // Returns true if the cell has performed some action. The cell must not be air.
     bool ApplyRules(sf::Vector2i p);
 
     bool ActionCell (CellState &cell, ConstProperties &constProp, sf::Vector2i p);
@@ -6,47 +6,130 @@
 #include "Constants.hpp"
 #include "Elements/ElementProperties.hpp"
 #include "FreeList.h"
+#include "RoomDirectory.hpp"
+#include "RoomPager.hpp"
+#include "Snapshot.hpp"
 #include "SandRoom.hpp"
 #include "Utility/Hashes.hpp"
-#include <SFML/Graphics.hpp>
+#include "Utility/JobSystem.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 
 #define VALID_ROOM(id) ((id) > -1)
 
 using roomID_t = int;
 
-struct Vector2iHash {
-    std::size_t operator()(sf::Vector2i const &p) const {
-        std::size_t h {std::hash<int>{}(p.x)};
-        HashCombine(h, p.y);
-        return h;
-    }
-};
+class SandWorker;
 
 class SandWorld {
-    using room_ptr = std::unique_ptr<SandRoom>;
+    using room_ptr      = std::unique_ptr<SandRoom>;
+    using worker_ptr    = std::unique_ptr<SandWorker>;
 public:
+    // Rooms that have been removed are left as null until their slot is reused.
     FreeList<room_ptr> rooms;
     
     // The properties of the elements being simulated in the world.
     ElementProperties properties;
 
 private:
-    std::unordered_map<sf::Vector2i, roomID_t, Vector2iHash> roomsMap;
-
+    // Declared before the directory, which is sized from them.
     const int xMin, xMax, // The horizontal limits (number of rooms) of the world.
               yMin, yMax; // The vertical limits of the world.
 
+    // The worker that simulates each room, which shares its room's ID. 
+    FreeList<worker_ptr> workers;
+    // Maps the key of each room to its ID.
+    RoomDirectory directory;
+    // Guards the rooms and the directory, as rooms may be spawned while other threads are looking rooms up.
+    // Lookups in a dense directory don't need the lock.
+    mutable std::shared_mutex roomsMutex;
+
+    // The rooms that have something to simulate next step, in no particular order. Rooms add themselves as they 
+    // wake up, so rooms that are asleep cost nothing to step.
+    std::vector<roomID_t> scheduled;
+    std::mutex scheduledMutex;
+
+    // The keys of the rooms that chunks have run into during the current phase, which are spawned once it's over.
+    std::vector<sf::Vector2i> requested;
+    std::mutex requestedMutex;
+
+    // Holds the rooms that have been paged out. Null unless paging is enabled.
+    std::unique_ptr<RoomPager> pager;
+    // The snapshot that the world was loaded from, which holds the rooms that haven't been restored yet.
+    std::unique_ptr<Snapshot> snapshot;
+
+    // Runs work in parallel across the world's threads.
+    std::unique_ptr<JobSystem> jobs;
+    // The number of steps that have been performed.
+    uint64_t ticks;
+    // The length of the windows that chunks are judged over, in steps, or zero if telemetry is disabled.
+    int telemetryWindow;
+    // How the particles of every room are moved.
+    Integrator integrator;
+
 public:
     SandWorld();
     SandWorld(int _xMin, int _xMax, int _yMin, int _yMax);
+    ~SandWorld();
 
     roomID_t SpawnRoom(int x, int y);
+    // Spawns the rooms that contain each of the given points in parallel. Returns the ID of each point's room.
+    std::vector<roomID_t> SpawnRooms(const std::vector<sf::Vector2i> &points);
+    // Removes the room that contains the point (x, y), along with its worker. Returns the ID of the room that 
+    // was removed, or -1 if there was no room.
     roomID_t RemoveRoom(int x, int y);
+    // Asks for the room that contains point p to be spawned at the end of the current phase of the step. Chunks 
+    // use this instead of spawning rooms themselves, so that rooms get the same IDs however the chunks are scheduled.
+    // May be called from several threads.
+    void RequestRoom(sf::Vector2i p);
+
+    // Pages idle rooms out to files in the given directory when they're far from the view. Paged out rooms are 
+    // reloaded when they're spawned again, so the rest of the world doesn't need to know about them.
+    void EnablePaging(const std::string &directory);
+    // Pages out idle rooms that are more than unloadRadius rooms from the focus point, along with their idle 
+    // neighbours, and reloads paged out rooms within loadRadius of it or next to an awake room. Rooms in between
+    // are read back in the background. Must be called between steps.
+    void PageRooms(sf::Vector2i focus, int loadRadius, int unloadRadius);
+    // Pages rooms in and out around a view with the given centre and size, then spawns the rooms under its corners.
+    // Returns each corner paired with the ID of its room, ordered BL -> BR -> TL -> TR. Must be called between steps.
+    std::vector<std::pair<sf::Vector2i, roomID_t>> FollowView(sf::Vector2i centre, sf::Vector2i size);
+
+    // Saves every room, including the ones that are paged out or haven't been restored yet. Particles aren't saved.
+    // Returns true if successful. Must be called between steps.
+    bool SaveSnapshot(const std::string &path);
+    // Replaces the world with the contents of a snapshot. Rooms that were awake are restored straight away, and
+    // the rest as they're spawned. Returns false, leaving the world as it was, if the snapshot can't be read.
+    // Must be called between steps.
+    bool LoadSnapshot(const std::string &path);
+
+    // Performs one iteration of the simulation across all rooms. Returns the number of cells that were updated.
+    size_t Step(float dt);
+    // Returns the number of steps that have been performed.
+    uint64_t Ticks() const;
+    // Sets how particles are moved. Particles use semi-implicit Euler by default.
+    void SetIntegrator(Integrator _integrator);
+    Integrator ParticleIntegrator() const;
+
+    // Runs the world's jobs across the given number of threads, including the calling thread. With more than one
+    // thread, the chunks within each room are simulated in parallel. The world is single-threaded by default.
+    void SetThreads(int numThreads);
+    JobSystem &Jobs() const;
+
+    // Counts what each chunk does every step while enabled. Chunks that stay awake for a window of the given 
+    // number of steps without much changing are reported as restless. A window of zero disables telemetry.
+    void EnableTelemetry(int window);
+    int TelemetryWindow() const;
+    // Writes the restless chunks of the rooms that are loaded, most restless first, and the element behind each.
+    void ReportRestlessChunks(std::ostream &out) const;
 
     // Access functions.
-    CellState &GetCell(int x, int y);
+    CellState GetCell(int x, int y);
     size_t CellIndex(sf::Vector2i p);
     SandRoom& GetRoom(roomID_t id);
     SandRoom& GetRoom(sf::Vector2i key);
@@ -79,6 +162,44 @@ private:
 
     // Returns the key to the room that contains the point (x, y).
     sf::Vector2i ToKey(int x, int y);
+    // Returns the ID of the room with the given key, or -1 if there is none.
+    roomID_t FindRoom(sf::Vector2i key) const;
+
+    // Builds the room with the given key, restoring its cells if it's stored. May be called from several threads.
+    room_ptr BuildRoom(sf::Vector2i key, bool &restored);
+    // Adds a built room to the world and gives it the next ID, unless the key already has a room. Returns the ID of
+    // the key's room.
+    roomID_t AddRoom(sf::Vector2i key, room_ptr room, bool restored);
+    // Spawns the rooms that were requested during the phase, in order of key.
+    void SpawnRequested();
+
+    // Decodes the stored cells of the room with the given key into a new room. Returns false if the room isn't 
+    // stored. If its cells can't be read, the room is left empty.
+    bool Restore(SandRoom &room, sf::Vector2i key);
+    // Drops the stored copy of a room once it has been restored.
+    void Release(sf::Vector2i key);
+    // Returns true if the room with the given key has been paged out or is waiting in a snapshot.
+    bool Stored(sf::Vector2i key) const;
+    // Restores the stored neighbours of each of the given rooms that is awake.
+    void RestoreNeighbours(const std::vector<SandWorker*> &awake);
+    // Returns true if a room has nothing that needs simulating.
+    bool Idle(const SandRoom &room) const;
+
+    // Links the room with the given key to each of its existing neighbours, and them to it. Passing a null room 
+    // unlinks the key's neighbours from it. The caller must hold the unique lock.
+    void LinkNeighbours(sf::Vector2i key, SandRoom *room);
+
+    // Returns the worker of the room with the given ID, or null if there's no such room.
+    SandWorker *Worker(roomID_t id) const;
+    // Returns the worker of each room, in order of room ID.
+    std::vector<SandWorker*> Workers() const;
+    // Returns the workers of the given rooms in order of room ID, skipping duplicates and rooms that don't exist.
+    std::vector<SandWorker*> Workers(std::vector<roomID_t> ids) const;
+    // Takes the rooms off the list of scheduled rooms and returns their workers, in order of room ID.
+    std::vector<SandWorker*> TakeScheduled();
+    // Hands the requests in a worker's outboxes to the rooms that they're for, and adds the ID of each of those 
+    // rooms to receivers.
+    void DeliverOutboxes(SandWorker &worker, std::vector<roomID_t> &receivers);
 
 };
 
@@ -0,0 +1,25 @@
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include "SandWorld.hpp"
+#include <string>
+
+/**
+ * A scenario is a plain-text file that describes the initial contents of a world, one command per line:
+ *
+ *      # Comments start with a hash.
+ *      room <x> <y>                                # Spawns the room that contains the point (x, y).
+ *      fill <element> <x> <y> <width> <height>     # Fills a rectangle with the named element.
+ *
+ * All coordinates are in world space. Rooms covered by a fill are spawned automatically.
+ */
+
+// Populates the world with the contents of the given scenario file. Returns true if successful, false otherwise.
+bool LoadScenario(SandWorld &world, const std::string &path);
+
+// Returns the element with the given name, or Element::null if no such element exists.
+Element ElementFromName(const ElementProperties &properties, const std::string &name);
+// Spawns every room that intersects the rectangle at (x, y) with the given width and height.
+void SpawnArea(SandWorld &world, int x, int y, int w, int h);
+
+#endif
@@ -30,6 +30,8 @@ public:
 
     // Repositions the centre of the current view to the given position in world space.
     void RepositionView(sf::Vector2f delta);
+    // Moves the centre of the current view to the given position in world space.
+    void CentreView(sf::Vector2f centre);
 
     sf::Vector2f ToWorld(const sf::Vector2i &point) const;
 
@@ -0,0 +1,73 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include "Utility/Hashes.hpp"
+#include "Utility/MappedFile.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A saved world. The file is laid out as:
+ * 
+ *      Header      "SANDSNAP", version, number of rooms, room and chunk dimensions, offset of the index.
+ *      Rooms       The cells of each room, as written by RoomCodec::Encode.
+ *      Index       For each room: its key, a mask of its awake chunks, and the offset and size of its cells.
+ * 
+ * Values are stored in the byte order of the machine that wrote them, which is little-endian on every platform the
+ * game runs on. Opening a snapshot maps the file and reads the index, and nothing else. A room's
+ * cells are only read when the room is taken.
+ */
+class Snapshot {
+public:
+    static constexpr uint32_t version {1};
+
+    // A room to be written to a snapshot.
+    struct Room {
+        sf::Vector2i    key;
+        uint64_t        awakeChunks;    // Bit i is set if chunk i of the room was awake.
+        const uint8_t  *data;           // The room's cells, as written by RoomCodec::Encode.
+        size_t          size;
+    };
+
+private:
+    struct Entry {
+        uint64_t            awakeChunks;
+        uint64_t            offset;
+        uint64_t            size;
+        std::atomic<bool>   taken {false};
+    };
+
+    std::unique_ptr<MappedFile> file;
+    std::unordered_map<sf::Vector2i, Entry, Vector2iHash> entries;
+    std::atomic<size_t> remaining {0};
+    bool valid {false};
+
+public:
+    // Writes the rooms to a snapshot file. Returns true if successful.
+    static bool Write(const std::string &path, const std::vector<Room> &rooms);
+
+    // Opens a snapshot. The snapshot is empty if the file couldn't be read or wasn't written for rooms of the 
+    // current dimensions.
+    explicit Snapshot(const std::string &path);
+
+    bool Valid() const;
+    // Returns the keys of every room in the snapshot.
+    std::vector<sf::Vector2i> Keys() const;
+    // Returns the number of rooms that haven't been taken yet.
+    size_t Remaining() const;
+
+    // Returns true if the snapshot holds the room and it hasn't been taken yet.
+    bool Contains(sf::Vector2i key) const;
+    // Returns the room's cells, or null if the snapshot doesn't hold the room. Sets the size of the cells and the
+    // mask of awake chunks. May be called from several threads at once.
+    const uint8_t *Cells(sf::Vector2i key, size_t &size, uint64_t &awakeChunks) const;
+    // Marks the room as taken, so that it's only restored once. Returns false if it already was.
+    bool Take(sf::Vector2i key);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef UTILITY_BITS_HPP
+#define UTILITY_BITS_HPP
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit. The word must not be zero.
+inline int LowestBit(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Index of the highest set bit. The word must not be zero.
+inline int HighestBit(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(word);
+#endif
+}
+
+// The number of set bits.
+inline int PopCount(uint64_t word) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+// A word with bits [begin, end) set, where 0 <= begin <= end <= 64.
+inline uint64_t BitRange(int begin, int end) {
+    uint64_t upper {end >= 64 ? ~uint64_t {0} : (uint64_t {1} << end) - 1};
+    return upper & ~((uint64_t {1} << begin) - 1);
+}
+
+#endif
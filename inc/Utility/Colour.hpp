@@ -0,0 +1,39 @@
+#ifndef UTILITY_COLOUR_HPP
+#define UTILITY_COLOUR_HPP
+
+#include <cstdint>
+#include <vector>
+
+// An RGBA colour with 8 bits per channel. Laid out as four bytes, so rows of colours can be uploaded as pixels.
+struct Colour {
+    uint8_t r {0}, g {0}, b {0}, a {255};
+
+    constexpr Colour() = default;
+    constexpr Colour(uint8_t _r, uint8_t _g, uint8_t _b, uint8_t _a=255) : r(_r), g(_g), b(_b), a(_a) {}
+    // Unpacks a colour from an integer in the form 0xRRGGBBAA.
+    constexpr explicit Colour(uint32_t rgba) :
+        r(static_cast<uint8_t>(rgba >> 24)), g(static_cast<uint8_t>(rgba >> 16)),
+        b(static_cast<uint8_t>(rgba >> 8)),  a(static_cast<uint8_t>(rgba)) {}
+
+    // Packs the colour into an integer in the form 0xRRGGBBAA.
+    constexpr uint32_t ToInteger() const {
+        return (static_cast<uint32_t>(r) << 24) | (static_cast<uint32_t>(g) << 16) | (static_cast<uint32_t>(b) << 8) | a;
+    }
+
+    constexpr bool operator==(const Colour &other) const {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+    constexpr bool operator!=(const Colour &other) const { return !(*this == other); }
+};
+
+static_assert(sizeof(Colour) == 4, "Colours must be packed as RGBA bytes.");
+
+// The pixels of an image, row by row from the top left.
+struct Texture {
+    unsigned width {0}, height {0};
+    std::vector<Colour> pixels;
+
+    Colour At(unsigned x, unsigned y) const { return pixels[x + y * width]; }
+};
+
+#endif
@@ -1,10 +1,40 @@
 #ifndef UTILITY_HASHES_HPP
 #define UTILITY_HASHES_HPP
 
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
 template <typename T, typename... Rest>
 void HashCombine(std::size_t &seed, const T &v, const Rest&... rest) {
     seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     (HashCombine(seed, rest), ...);
 }
 
-#endif
\ No newline at end of file
+// The splitmix64 finaliser. Every input bit affects every output bit, so nearby keys are spread across the table.
+inline uint64_t MixBits(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Packs a pair of coordinates into a single 64 bit key.
+inline uint64_t PackPoint(int x, int y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+inline uint64_t HashPoint(int x, int y) {
+    return MixBits(PackPoint(x, y));
+}
+
+struct Vector2iHash {
+    std::size_t operator()(sf::Vector2i const &p) const {
+        return static_cast<std::size_t>(HashPoint(p.x, p.y));
+    }
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef UTILITY_JOB_SYSTEM_HPP
+#define UTILITY_JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Tracks the completion of a set of jobs.
+class TaskGroup {
+    friend JobSystem;
+private:
+    std::atomic<int> pending {0};
+
+public:
+    // Returns true once every job that was run in the group has completed.
+    bool Done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct WorkerStats {
+    uint64_t jobsRun    = 0;    // The number of jobs this worker has completed.
+    uint64_t jobsStolen = 0;    // The number of those jobs that were taken from another worker's queue.
+    uint64_t idleNs     = 0;    // Time spent waiting for work [nanoseconds].
+};
+
+/**
+ * A work-stealing job system. Every worker owns a deque of jobs: it pushes and pops its own jobs at the back,
+ * and steals from the front of the other workers' deques when it runs out. Slot 0 belongs to the thread that
+ * created the system, which runs jobs while it waits on a task group instead of blocking.
+ */
+class JobSystem {
+private:
+    struct Job {
+        std::function<void()> fn;
+        TaskGroup *group;
+    };
+
+    struct Worker {
+        std::mutex      mutex;
+        std::deque<Job> jobs;
+
+        std::atomic<uint64_t> jobsRun    {0};
+        std::atomic<uint64_t> jobsStolen {0};
+        std::atomic<uint64_t> idleNs     {0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex              sleepMutex;
+    std::condition_variable sleep;      // Idle workers wait here until a job is pushed.
+    std::atomic<int>        queued;     // The number of jobs that are waiting in a deque.
+    std::atomic<bool>       stopping;
+
+public:
+    // Creates a job system that runs across the given number of threads, including the calling thread.
+    explicit JobSystem(int numThreads=1);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Queues a job on the calling thread's deque as part of the given group.
+    void Run(TaskGroup &group, std::function<void()> fn);
+    // Runs queued jobs on the calling thread until every job in the group has completed.
+    void Wait(TaskGroup &group);
+
+    // Calls fn(i) for every i in [begin, end), in batches of up to grain indices, and waits for every call to complete.
+    void ParallelFor(int begin, int end, int grain, const std::function<void(int)> &fn);
+    // As above, but passes each batch to fn as the range [batchBegin, batchEnd).
+    void ParallelForRange(int begin, int end, int grain, const std::function<void(int, int)> &fn);
+
+    // Returns the number of threads that jobs are run on, including the thread that created the system.
+    int Size() const;
+
+    // Per-worker counters, indexed by worker. Worker 0 is the thread that created the system.
+    std::vector<WorkerStats> Stats() const;
+    void ResetStats();
+
+    // Returns the worker slot [0, Size()) of the calling thread. Threads that aren't workers use slot 0.
+    int ThisWorker() const;
+
+private:
+    void WorkerLoop(int index);
+
+    // Takes a job from the given worker's own deque, or steals one from another worker.
+    bool TakeJob(int index, Job &job, bool &stolen);
+    void Execute(int index, Job &job, bool stolen);
+};
+
+#endif
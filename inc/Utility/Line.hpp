@@ -1,11 +1,47 @@
 #ifndef UTILITY_LINE_HPP
 #define UTILITY_LINE_HPP
 
+#include <algorithm>
+#include <cstdlib>
 #include <iterator>
 #include <SFML/System/Vector2.hpp>
 
 namespace impl {
 
+// One axis of a line that is split into N steps. After step i, the offset from the start of the line is
+// delta * i / N rounded to the nearest integer, with halves rounded away from zero. The offset is kept as the
+// quotient and remainder of (2|delta|i + N) / 2N, so moving along the line only takes additions.
+class LineAxis {
+private:
+    int sign;
+    int twiceDelta, twiceN;
+    int quotient,   remainder;
+
+public:
+    constexpr LineAxis(int delta, int N, int step) :
+        sign((delta > 0) - (delta < 0)), twiceDelta(2 * std::abs(delta)), twiceN(2 * std::max(N, 1)),
+        quotient((twiceDelta * step + twiceN / 2) / twiceN), remainder((twiceDelta * step + twiceN / 2) % twiceN) {}
+
+    // |delta| <= N, so the offset changes by at most one per step.
+    constexpr void Increment() {
+        remainder += twiceDelta;
+        if (remainder >= twiceN) {
+            remainder -= twiceN;
+            ++quotient;
+        }
+    }
+
+    constexpr void Decrement() {
+        remainder -= twiceDelta;
+        if (remainder < 0) {
+            remainder += twiceN;
+            --quotient;
+        }
+    }
+
+    constexpr int Offset() const { return sign * quotient; }
+};
+
 class LerpIterator {
 public:
     using value_type        = sf::Vector2i;
@@ -14,44 +50,145 @@ public:
     using reference         = sf::Vector2i&;
     using iterator_category = std::bidirectional_iterator_tag;
 
-    explicit LerpIterator(sf::Vector2f start, sf::Vector2f end, int step, int N);
+    explicit LerpIterator(sf::Vector2i start, sf::Vector2i end, int step, int N) :
+        x0(start.x), y0(start.y), x(end.x - start.x, N, step), y(end.y - start.y, N, step), N(N), step(step) {}
 
     // Dereference operator.
-    value_type operator*() const;
+    value_type operator*() const { return value_type(x0 + x.Offset(), y0 + y.Offset()); }
 
     // Pre- and post-incrementable operators.
-    LerpIterator& operator++();
-    LerpIterator operator++(int);
+    LerpIterator& operator++() {
+        ++step;
+        x.Increment();
+        y.Increment();
+        return *this;
+    }
+    LerpIterator operator++(int) {
+        LerpIterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
 
     // Pre- and post-decrementable operators.
-    LerpIterator& operator--();
-    LerpIterator operator--(int);
+    LerpIterator& operator--() {
+        --step;
+        x.Decrement();
+        y.Decrement();
+        return *this;
+    }
+    LerpIterator operator--(int) {
+        LerpIterator tmp = *this;
+        --*this;
+        return tmp;
+    }
 
     // Equality / inequality operators.
-    bool operator==(const LerpIterator &rhs);
-    bool operator!=(const LerpIterator &rhs);
+    bool operator==(const LerpIterator &rhs) const { return step == rhs.step && N == rhs.N; }
+    bool operator!=(const LerpIterator &rhs) const { return !(*this == rhs); }
 
 private:
-    const sf::Vector2f start;
-    const sf::Vector2f end;
-    const int N;
+    int x0, y0;
+    LineAxis x, y;
+    int N;
     int step;
 };
 
+// Walks every cell that a line passes through, taking one step along a single axis at a time. The steps are
+// taken in the order in which the line crosses the cell borders, so the iterator can keep going past the end.
+class SupercoverIterator {
+public:
+    using value_type        = sf::Vector2i;
+    using difference_type   = int;
+    using pointer           = sf::Vector2i*;
+    using reference         = sf::Vector2i&;
+    using iterator_category = std::bidirectional_iterator_tag;
+
+    // Starts the iterator after the given number of steps along each axis.
+    explicit SupercoverIterator(sf::Vector2i start, sf::Vector2i end, int xSteps, int ySteps) :
+        x0(start.x), y0(start.y),
+        nx(std::abs(end.x - start.x)), ny(std::abs(end.y - start.y)),
+        sgnx((end.x > start.x) - (end.x < start.x)), sgny((end.y > start.y) - (end.y < start.y)),
+        x(xSteps), y(ySteps) {}
+
+    // Dereference operator.
+    value_type operator*() const { return value_type(x0 + sgnx * x, y0 + sgny * y); }
+
+    // Pre- and post-incrementable operators. Steps along whichever axis crosses its next border first, which is
+    // (0.5 + x) / nx < (0.5 + y) / ny without the division.
+    SupercoverIterator& operator++() {
+        if ((1 + 2 * x) * ny < (1 + 2 * y) * nx) {
+            ++x;
+        } else {
+            ++y;
+        }
+        return *this;
+    }
+    SupercoverIterator operator++(int) {
+        SupercoverIterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    // Pre- and post-decrementable operators. Undoes whichever axis crossed its last border most recently.
+    SupercoverIterator& operator--() {
+        if (y == 0 || (x > 0 && (2 * x - 1) * ny >= (2 * y - 1) * nx)) {
+            --x;
+        } else {
+            --y;
+        }
+        return *this;
+    }
+    SupercoverIterator operator--(int) {
+        SupercoverIterator tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    // Equality / inequality operators.
+    bool operator==(const SupercoverIterator &rhs) const { return x == rhs.x && y == rhs.y; }
+    bool operator!=(const SupercoverIterator &rhs) const { return !(*this == rhs); }
+
+    // The number of steps taken along each axis.
+    sf::Vector2i Steps() const { return sf::Vector2i(x, y); }
+
+private:
+    int x0, y0;
+    int nx, ny;     // The number of cells to move along each axis.
+    int sgnx, sgny; // The direction to step.
+    int x, y;       // The number of steps that have been taken along each axis.
+};
+
 }
 
+// The cells along a line from start to finish, including both ends, with one cell per step along the longer axis.
 class Lerp {
 public:
-    Lerp(sf::Vector2i start, sf::Vector2i finish);
+    Lerp(sf::Vector2i start, sf::Vector2i finish) :
+        start(start), finish(finish), N(std::max(std::abs(finish.x - start.x), std::abs(finish.y - start.y))) {}
 
     using iterator = impl::LerpIterator;
-    iterator begin() const;
-    iterator end() const;
+    iterator begin() const { return iterator(start, finish, 0, N); }
+    iterator end() const { return iterator(start, finish, N + 1, N); }
 
 private:
-    const sf::Vector2f start;
-    const sf::Vector2f finish;
+    const sf::Vector2i start;
+    const sf::Vector2i finish;
     const int N;
 };
 
-#endif
\ No newline at end of file
+// Every cell that a line from start to finish passes through, including both ends.
+class Supercover {
+public:
+    Supercover(sf::Vector2i start, sf::Vector2i finish) : start(start), finish(finish) {}
+
+    using iterator = impl::SupercoverIterator;
+    iterator begin() const { return iterator(start, finish, 0, 0); }
+    // One step past the finish.
+    iterator end() const { return ++iterator(start, finish, std::abs(finish.x - start.x), std::abs(finish.y - start.y)); }
+
+private:
+    const sf::Vector2i start;
+    const sf::Vector2i finish;
+};
+
+#endif
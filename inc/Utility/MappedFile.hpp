@@ -0,0 +1,32 @@
+#ifndef UTILITY_MAPPED_FILE_HPP
+#define UTILITY_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A read-only view of a whole file. The file is memory-mapped where the platform supports it, so pages are only 
+ * read from disk when they're touched. Elsewhere, the file is read into memory up front.
+ */
+class MappedFile {
+private:
+    const uint8_t *data;
+    size_t size;
+    std::vector<uint8_t> buffer; // Holds the file when it can't be mapped.
+
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns true if the file was opened.
+    bool Valid() const { return data != nullptr; }
+    const uint8_t *Data() const { return data; }
+    size_t Size() const { return size; }
+};
+
+#endif
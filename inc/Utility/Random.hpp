@@ -1,26 +1,87 @@
 #ifndef UTILITY_RANDOM_HPP
 #define UTILITY_RANDOM_HPP
 
-// Seeds the random number generator.
+#include <cstdint>
+
+/**
+ * xoshiro256**, a small and fast generator with 256 bits of state. Each thread has its own, so drawing numbers
+ * never touches shared state. Coin flips are taken one bit at a time from a buffered 64 bit draw.
+ */
+class Rng {
+private:
+    uint64_t state[4];
+    uint64_t bits;      // Buffered bits for coin flips.
+    int      numBits;   // The number of bits left in the buffer.
+
+public:
+    explicit Rng(uint64_t seed=0) { Seed(seed); }
+
+    // Restarts the sequence. Generators with the same seed give the same numbers.
+    void Seed(uint64_t seed);
+
+    uint64_t Next() {
+        const uint64_t result {Rotate(state[1] * 5, 7) * 9};
+        const uint64_t t {state[1] << 17};
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = Rotate(state[3], 45);
+        return result;
+    }
+
+    // Returns an integer from [0, upper), or 0 if upper isn't positive.
+    int Below(int upper) {
+        if (upper <= 0) return 0;
+        return static_cast<int>(((Next() >> 32) * static_cast<uint64_t>(upper)) >> 32);
+    }
+
+    bool Bit() {
+        if (numBits == 0) {
+            bits    = Next();
+            numBits = 64;
+        }
+        const bool bit {(bits & 1) != 0};
+        bits >>= 1;
+        --numBits;
+        return bit;
+    }
+
+private:
+    static uint64_t Rotate(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// Seeds the random number generators with a random seed.
 void InitRng();
+// Seeds the random number generators. Single threaded runs with the same seed make the same random decisions.
+void InitRng(uint64_t seed);
+// Returns the seed that the generators were last seeded with.
+uint64_t RngSeed();
+
+// Restarts the calling thread's generator on a sequence of its own, picked by the seed and the given keys. Work that
+// starts its own sequence draws the same numbers regardless of which thread it runs on.
+void SeedStream(uint64_t tick, uint64_t key, uint64_t stream);
 
-// Returns a random integer from the interval [a, b).
-// Uses std::rand(), which is messy but fast.
+// Returns the calling thread's generator.
+Rng &ThreadRng();
+
+// Returns a random integer from the interval [0, upper).
 int QuickRandInt(int upper);
 
-// Returns a random integer between a and b.
-// Uses std::rand(), which is messy but fast.
+// Returns a random integer from the interval [a, b], each with the same odds.
 int QuickRandRange(int a, int b);
 
 // Returns true with a probability of the given percent.
 bool Probability(int percent);
 
-// Returns a random integer from the interval [a, b).
-// Uses a Mersenne Twister, which is slow but provides better randomness.
+// Returns true half of the time. Cheaper than Probability(50), as each call only uses one random bit.
+bool CoinFlip();
+
+// Returns a random integer from the interval [0, upper).
 int RandInt(int upper);
 
-// Returns a random integer between a and b.
-// Uses a Mersenne Twister, which is slow but provides better randomness.
+// Returns a random integer from the interval [a, b], each with the same odds.
 int RandRange(int a, int b);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,45 @@
+#ifndef UTILITY_RAY_TABLE_HPP
+#define UTILITY_RAY_TABLE_HPP
+
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Supercover lines from the origin to each point on the circumference of a circle, traced once up front.
+ * Every ray also has an extension, which carries on in the same direction from wherever the ray was stopped.
+ */
+class RayTable {
+public:
+    struct Ray {
+        sf::Vector2i target;        // The point on the circumference that the ray ends at.
+        sf::Vector2f direction;     // Unit vector from the origin towards the target.
+        uint32_t begin, end;        // The cells from the origin up to (but excluding) the target.
+        uint32_t extensionBegin,
+                 extensionEnd;      // The cells of the extension, relative to the point that it starts from.
+        int extensionLimit;         // Half the number of cells that the ray spans along its longer axis.
+    };
+
+private:
+    std::vector<Ray>          rays;
+    std::vector<sf::Vector2i> offsets;  // The cells of every ray and extension.
+    std::vector<int>          rings;    // For each cell, the larger of the number of steps taken along each axis.
+    int extent;
+
+public:
+    // Traces a ray to each point of a circle with the given radius, leaving out repeated points.
+    explicit RayTable(float radius);
+
+    const std::vector<Ray> &Rays() const { return rays; }
+    sf::Vector2i Offset(uint32_t i) const { return offsets[i]; }
+    // The cells of an extension that are within a radius r of its start are the ones with Ring(i) < r.
+    int Ring(uint32_t i) const { return rings[i]; }
+
+    // Every ray, followed by any of its extensions, lies within [-Extent(), Extent()] on both axes.
+    int Extent() const { return extent; }
+
+private:
+    void Trace(sf::Vector2i target);
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef UTILITY_STATS_HPP
+#define UTILITY_STATS_HPP
+
+#include <cstddef>
+#include <vector>
+
+// A summary of a set of samples, such as frame times.
+struct Summary {
+    size_t count {0};
+    float  mean  {0.f};
+    float  min   {0.f};
+    float  p50   {0.f};
+    float  p95   {0.f};
+    float  p99   {0.f};
+    float  max   {0.f};
+};
+
+// Returns the summary of the given samples, or an empty summary if there are none. Percentiles are taken with the
+// nearest rank method.
+Summary Summarise(std::vector<float> samples);
+
+#endif
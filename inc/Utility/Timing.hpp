@@ -0,0 +1,57 @@
+#ifndef UTILITY_TIMING_HPP
+#define UTILITY_TIMING_HPP
+
+#include "Utility/Stats.hpp"
+#include <cstdint>
+#include <string>
+
+// The stages of a frame that are timed. Stages that run in parallel across rooms add up the time spent on every
+// thread, so they can take longer than the frame.
+enum class Stage {
+    PARTICLES = 0,          // Moving the particles, at the start of each room's step.
+    CHUNKS,                 // The four phases of chunk updates.
+    BLASTS,                 // Resolving the explosions.
+    CONSOLIDATE_ACTIONS,    // Picking and performing the queued actions.
+    CONSOLIDATE_MOVEMENT,   // Picking and performing the queued moves.
+    FINISH,                 // Performing the moves between rooms.
+    VISIBLE_ROOMS,          // Paging and spawning the rooms around the view.
+    DRAW,
+    count
+};
+
+// Returns the short name of a stage, as used in the overlay and exports.
+const char *StageName(Stage stage);
+
+// Adds the time from its construction to its destruction to a stage of the current frame.
+class StageTimer {
+private:
+    const Stage    stage;
+    const uint64_t start;
+
+public:
+    explicit StageTimer(Stage stage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+};
+
+// Adds the given time [nanoseconds] to a stage of the current frame. Safe to call from any thread.
+void AddStageTime(Stage stage, uint64_t ns);
+
+// Clears the recorded frames and starts the first frame now.
+void ResetFrameTimes();
+// Closes the current frame, whose length is the time since the last frame was closed. Its times go into the rolling
+// window and the histogram. Must only be called between steps.
+void EndFrame();
+// Returns the summary of a stage's time [milliseconds] over the recent frames.
+Summary RecentStageTimes(Stage stage);
+// Returns the summary of the frame length [milliseconds] over the recent frames.
+Summary RecentFrameTimes();
+
+// Writes the histogram of every frame's length since the start, with the mean time of each stage for the frames
+// in each bin, so the stages behind slow frames stand out. Written as JSON if the path ends in ".json", and as
+// CSV otherwise. Returns true if successful, false otherwise.
+bool ExportFrameTimes(const std::string &path);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef UTILITY_TRACE_HPP
+#define UTILITY_TRACE_HPP
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Records when a span of work began and ended on the calling thread, while a trace is being captured. Each thread
+ * writes to a ring buffer of its own, so recording never waits on another thread. When nothing is being captured,
+ * a scope costs one relaxed load. Names must be string literals, as only the pointers are kept.
+ */
+class TraceScope {
+private:
+    const char *name;
+    const char *argNames[2];
+    int64_t     args[2];
+    uint64_t    start;      // Zero if the scope began while nothing was being captured.
+
+public:
+    explicit TraceScope(const char *name, const char *argName0=nullptr, int64_t arg0=0,
+                                          const char *argName1=nullptr, int64_t arg1=0);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+// Names the calling thread in the traces it appears in.
+void SetTraceThreadName(const std::string &name);
+
+// Starts capturing the given number of frames, which are written to the given path as Chrome trace-event JSON once
+// they've been captured. Replaces any capture that is in progress. Must be called between frames.
+void StartTrace(int frames, const std::string &path);
+// Returns true while frames are being captured.
+bool Tracing();
+// Marks the end of a frame. Writes the trace once the last frame of a capture ends. Must be called between frames.
+void EndTraceFrame();
+
+#endif
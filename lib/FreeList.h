@@ -79,7 +79,7 @@ int FreeList<T>::Insert(T element) {
 template <class T>
 void FreeList<T>::Erase(int n) {
     next[n] = firstFree;
-    data.erase(data.begin() + n);
+    data[n] = T(); // The slot stays in place so that the indices of the other elements don't change.
     firstFree = n;
 }
 
@@ -0,0 +1,87 @@
+#include "Canvas.hpp"
+#include <algorithm>
+
+static_assert(sizeof(Colour) == 4, "Canvas pixels are uploaded directly as RGBA bytes.");
+
+namespace {
+
+    // Runs of written rows that are separated by fewer clean rows than this are uploaded together.
+    const int mergeGap {16};
+
+}
+
+Canvas::Canvas(int _width, int _height) : 
+    width(_width), height(_height), 
+    pixels(_width * _height, Colour(0, 0, 0)),
+    dirtyMin(_height), dirtyMax(_height),
+    written(_height, 0) {
+    MarkAll();
+}
+
+void Canvas::SetPixel(int x, int y, Colour colour) {
+    pixels[x + y * width] = colour;
+    MarkWritten(y, y + 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Dirty tracking.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void Canvas::MarkDirty(int xMin, int yMin, int xMax, int yMax) {
+    xMin = std::max(xMin, 0); xMax = std::min(xMax, width);
+    yMin = std::max(yMin, 0); yMax = std::min(yMax, height);
+    if (xMin >= xMax) return;
+
+    for (int y = yMin; y < yMax; ++y) {
+        if (dirtyMin[y] >= dirtyMax[y]) {
+            dirtyMin[y] = xMin;
+            dirtyMax[y] = xMax;
+        } else {
+            dirtyMin[y] = std::min(dirtyMin[y], xMin);
+            dirtyMax[y] = std::max(dirtyMax[y], xMax);
+        }
+    }
+}
+
+void Canvas::MarkAll() {
+    MarkDirty(0, 0, width, height);
+}
+
+bool Canvas::TakeDirtySpan(int y, int &xMin, int &xMax) {
+    xMin = dirtyMin[y];
+    xMax = dirtyMax[y];
+    dirtyMin[y] = width;
+    dirtyMax[y] = 0;
+
+    return xMin < xMax;
+}
+
+void Canvas::MarkWritten(int yMin, int yMax) {
+    std::fill(written.begin() + std::max(yMin, 0), written.begin() + std::min(yMax, height), 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Uploading.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int Canvas::Upload(sf::Texture &texture) {
+    int uploaded {0};
+    int y {0};
+    while (y < height) {
+        if (!written[y]) { ++y; continue; }
+
+        // Extend the band until there's a long enough run of clean rows.
+        int bandEnd {y + 1};
+        for (int next = bandEnd; next < height && next < bandEnd + mergeGap; ++next) {
+            if (written[next]) bandEnd = next + 1;
+        }
+
+        // Bands are uploaded at full width, as the pixels of a narrower rect wouldn't be contiguous.
+        texture.update(reinterpret_cast<const sf::Uint8*>(Row(y)), width, bandEnd - y, 0, y);
+        std::fill(written.begin() + y, written.begin() + bandEnd, 0);
+        uploaded += bandEnd - y;
+        y = bandEnd;
+    }
+
+    return uploaded;
+}
@@ -1,43 +1,106 @@
 #include "Cell.hpp"
 #include "Constants.hpp"
 #include "Elements/ElementProperties.hpp"
-#include <SFML/Graphics/Color.hpp>
 #include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+
+static_assert(static_cast<int>(Element::count) <= UINT8_MAX, "Element ids must fit in the uint8_t id plane.");
+
+impl::PackedVelocity impl::PackedVelocity::Pack(sf::Vector2f v) {
+    const float limit {INT16_MAX / scale};
+    return PackedVelocity {
+        static_cast<int16_t>(std::lround(std::clamp(v.x, -limit, limit) * scale)),
+        static_cast<int16_t>(std::lround(std::clamp(v.y, -limit, limit) * scale))
+    };
+}
+
+CellState::CellState(Cells &cells, size_t i) :
+    id(&cells.ids[i]),
+    health(&cells.healths, i),
+    velocity(&cells.velocities[i]),
+    data(&cells.datas, i) {}
 
 void CellState::ApplyAcceleration(sf::Vector2f acc, float dt) {
-    velocity += acc * dt;
-    std::clamp(velocity.x, -constants::maxVelocity, constants::maxVelocity);
-    std::clamp(velocity.y, -constants::maxVelocity, constants::maxVelocity);
+    sf::Vector2f v {velocity};
+    v += acc * dt;
+    v.x = std::clamp(v.x, -constants::maxVelocity, constants::maxVelocity);
+    v.y = std::clamp(v.y, -constants::maxVelocity, constants::maxVelocity);
+    velocity = v;
 }
 
 
 Cells::Cells(int width, int height, const ElementProperties *_properties) : 
-    properties(_properties),
-    state(width * height, CellState()),
-    colour(width * height, _properties->Colour(Element::air, 0, 0)) {}
+    colour(width * height, _properties->Colour(Element::air, 0, 0)),
+    ids(width * height, static_cast<uint8_t>(Element::air)),
+    velocities(width * height),
+    healths(width * height, 100.f),
+    datas(width * height, 0),
+    width(width),
+    rowWords((width + 63) / 64),
+    occupied(rowWords * height, 0),
+    properties(_properties) {}
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //  Assignment / Manipulation functions.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-void Cells::Assign(size_t i, Element _id, sf::Color newColour) {
-    state[i]    = CellState(_id);
-    colour[i]   = newColour;
+void Cells::Assign(size_t i, Element _id, Colour newColour) {
+    ids[i]          = static_cast<uint8_t>(_id);
+    velocities[i]   = impl::PackedVelocity {};
+    healths.Reset(i);
+    datas.Reset(i);
+    colour[i]       = newColour;
+    UpdateOccupied(i);
 }
 
 void Cells::Assign(size_t i, Element _id, int x, int y) {
     Assign(i, _id, properties->Colour(_id, x, y));
 }
 
+void Cells::Swap(size_t i, Cells &other, size_t j) {
+    std::swap(ids[i], other.ids[j]);
+    std::swap(velocities[i], other.velocities[j]);
+    std::swap(colour[i], other.colour[j]);
+    UpdateOccupied(i);
+    other.UpdateOccupied(j);
+
+    // Only allocate the optional planes when there's something in them to carry across.
+    if (healths.Allocated() || other.healths.Allocated()) {
+        std::swap(healths.Ref(i), other.healths.Ref(j));
+    }
+    if (datas.Allocated() || other.datas.Allocated()) {
+        std::swap(datas.Ref(i), other.datas.Ref(j));
+    }
+}
+
+void Cells::UpdateOccupied(size_t i) {
+    const int col {static_cast<int>(i % width)};
+    uint64_t &word  {occupied[(i / width) * rowWords + col / 64]};
+    uint64_t  bit   {uint64_t {1} << (col % 64)};
+    if (ids[i] != Element::air) word |=  bit;
+    else                        word &= ~bit;
+}
+
+void Cells::RebuildOccupied() {
+    std::fill(occupied.begin(), occupied.end(), 0);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] != Element::air) {
+            const int col {static_cast<int>(i % width)};
+            occupied[(i / width) * rowWords + col / 64] |= uint64_t {1} << (col % 64);
+        }
+    }
+}
+
 void Cells::Darken(size_t i) {
-    sf::Color &cellColour {colour[i]};
+    Colour &cellColour {colour[i]};
     cellColour.r = std::clamp(static_cast<int>((cellColour.r * 3.f) / 4.f), 25, 255);
     cellColour.g = std::clamp(static_cast<int>((cellColour.g * 3.f) / 4.f), 25, 255);
     cellColour.b = std::clamp(static_cast<int>((cellColour.b * 3.f) / 4.f), 25, 255);
 }
 
 const ConstProperties& Cells::GetProperties(int index) const {
-    return properties->constants.at(state[index].id);
+    return properties->constants.at(ids[index]);
 }
 
 bool Cells::CanDisplace(Element self, Element other) const {
@@ -45,9 +108,9 @@ bool Cells::CanDisplace(Element self, Element other) const {
 }
 
 int Cells::SpreadRate(size_t i) const {
-    return properties->constants[state[i].id].spreadRate;
+    return properties->constants[ids[i]].spreadRate;
 }
 
 float Cells::Flammability(size_t i) const {
-    return properties->constants[state[i].id].flammability;
+    return properties->constants[ids[i]].flammability;
 }
@@ -1,5 +1,24 @@
 #include "Chunks.hpp"
+#include "Utility/Bits.hpp"
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
+
+namespace {
+
+    // Atomically replaces the value with the given value if it is smaller.
+    void AtomicMin(std::atomic<int> &value, int candidate) {
+        int current {value.load(std::memory_order_relaxed)};
+        while (candidate < current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {}
+    }
+
+    // Atomically replaces the value with the given value if it is larger.
+    void AtomicMax(std::atomic<int> &value, int candidate) {
+        int current {value.load(std::memory_order_relaxed)};
+        while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {}
+    }
+
+}
 
 Chunk::Chunk() : 
     state       (false),
@@ -19,11 +38,12 @@ void Chunk::Reset(ChunkBounds bounds) {
 }
 
 void Chunk::KeepAlive(int x, int y, ChunkBounds bounds) {
-    nextState = true;
-    xMinW = std::clamp(std::min(x - 2, xMinW), bounds.x, bounds.x + bounds.width);
-    xMaxW = std::clamp(std::max(x + 3, xMaxW), bounds.x, bounds.x + bounds.width);
-    yMinW = std::clamp(std::min(y - 2, yMinW), bounds.y, bounds.y + bounds.height);
-    yMaxW = std::clamp(std::max(y + 3, yMaxW), bounds.y, bounds.y + bounds.height);
+    nextState.store(true, std::memory_order_relaxed);
+    // The working rect always lies within the bounds, so clamping the candidate is equivalent to clamping the result.
+    AtomicMin(xMinW, std::clamp(x - 2, bounds.x, bounds.x + bounds.width));
+    AtomicMax(xMaxW, std::clamp(x + 3, bounds.x, bounds.x + bounds.width));
+    AtomicMin(yMinW, std::clamp(y - 2, bounds.y, bounds.y + bounds.height));
+    AtomicMax(yMaxW, std::clamp(y + 3, bounds.y, bounds.y + bounds.height));
 }
 
 void Chunk::Update(ChunkBounds bounds) {
@@ -36,10 +56,19 @@ void Chunk::Update(ChunkBounds bounds) {
     yMax = yMaxW; yMaxW = bounds.y - 1;
 }
 
+ChunkBounds Chunk::Changed() const {
+    const int left   {std::min(xMin, xMinW.load())}, right {std::max(xMax, xMaxW.load())};
+    const int bottom {std::min(yMin, yMinW.load())}, top   {std::max(yMax, yMaxW.load())};
+    return ChunkBounds{left, bottom, right - left, top - bottom};
+}
+
 Chunks::Chunks(int width, int height, int chunkWidth, int chunkHeight, int xOffset, int yOffset) : 
     width(width),   xOffset(xOffset), chunkWidth(chunkWidth),
     height(height), yOffset(yOffset), chunkHeight(chunkHeight),
-    chunks(width * height) {
+    chunks(width * height), awake(0), nextAwake(0) {
+    if (width * height > 64) {
+        throw std::runtime_error("Rooms can't contain more than 64 chunks.");
+    }
     Reset();
 }
 
@@ -52,6 +81,8 @@ void Chunks::Reset() {
 void Chunks::ResetChunk(int index) {
     ChunkBounds bounds {GetBounds(index)};
     GetChunk(index).Reset(bounds);
+    awake &= ~(uint64_t {1} << index);
+    nextAwake.fetch_and(~(uint64_t {1} << index), std::memory_order_relaxed);
 }
 
 void Chunks::ResetChunk(int x, int y) {
@@ -67,8 +98,28 @@ void Chunks::ResetContaining(int x, int y) {
 //////////////////////////////////////////////////////////////////////////////////////////
 
 void Chunks::KeepContainingAlive(int x, int y) {
-    ChunkBounds bounds {GetContainingBounds(x, y)};
-    GetContainingChunk(x, y).KeepAlive(x, y, bounds);
+    const int index {Hash(x, y)};
+    ChunkBounds bounds {GetBounds(index)};
+    GetChunk(index).KeepAlive(x, y, bounds);
+    MarkAwake(index);
+}
+
+void Chunks::Wake(int index) {
+    ChunkBounds bounds {GetBounds(index)};
+    chunks[index].KeepAlive(bounds.x, bounds.y, bounds);
+    chunks[index].KeepAlive(bounds.x + bounds.width - 1, bounds.y + bounds.height - 1, bounds);
+    MarkAwake(index);
+}
+
+void Chunks::SetWakeHandler(std::function<void()> handler) {
+    onWake = std::move(handler);
+}
+
+void Chunks::MarkAwake(int index) {
+    const uint64_t bit {uint64_t {1} << index};
+    // Most calls are for chunks that are already marked, so the shared word is only written to once per chunk.
+    if (nextAwake.load(std::memory_order_relaxed) & bit) return;
+    if (nextAwake.fetch_or(bit, std::memory_order_relaxed) == 0 && onWake) onWake();
 }
 
 void Chunks::KeepNeighbourAlive(int x, int y) {
@@ -96,6 +147,17 @@ void Chunks::UpdateChunk(int index) {
     GetChunk(index).Update(bounds);
 }
 
+uint64_t Chunks::Update() {
+    const uint64_t next {nextAwake.exchange(0, std::memory_order_relaxed)};
+    // Chunks that were awake are updated too, so that their dirty rects are cleared as they fall asleep.
+    for (uint64_t touched {awake | next}; touched; touched &= touched - 1) {
+        UpdateChunk(LowestBit(touched));
+    }
+    awake = next;
+
+    return awake;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //  Query functions.
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -128,10 +190,25 @@ sf::Vector2i Chunks::ContainingChunk(int x, int y) const {
     return sf::Vector2i((x - xOffset) / chunkWidth, (y - yOffset) / chunkHeight);
 }
 
+uint64_t Chunks::AwakeMask() const {
+    return awake | nextAwake.load(std::memory_order_relaxed);
+}
+
+bool Chunks::Asleep() const {
+    return AwakeMask() == 0;
+}
+
 size_t Chunks::Size() const {
     return width * height;
 }
 
+int Chunks::Phase(int index) const {
+    int yChunk {index / width};
+    int xChunk {index % width};
+
+    return (xChunk % 2) + 2 * (yChunk % 2);
+}
+
 ChunkBounds Chunks::GetBounds(int cx, int cy) const {
     return ChunkBounds{cx * chunkWidth + xOffset, cy * chunkHeight + yOffset, chunkWidth, chunkHeight};
 }
@@ -0,0 +1,60 @@
+#include "Compositor.hpp"
+#include <algorithm>
+
+Compositor::Compositor(Canvas &_canvas) : canvas(_canvas) {}
+
+void Compositor::Compose(JobSystem &jobs, const std::vector<RoomRegion> &regions, sf::Vector2i origin) {
+    // Restore the cells underneath the particles from last frame.
+    for (sf::Vector2i p : drawnParticles) {
+        canvas.MarkDirty(p.x, p.y, p.x + 1, p.y + 1);
+    }
+    drawnParticles.clear();
+
+    ComposeCells(jobs, regions, origin);
+    ComposeParticles(regions, origin);
+}
+
+void Compositor::ComposeCells(JobSystem &jobs, const std::vector<RoomRegion> &regions, sf::Vector2i origin) {
+    // Enough batches for each thread to steal a few, but big enough that a batch is worth scheduling.
+    const int grain {std::max(8, canvas.Height() / (4 * jobs.Size()))};
+
+    jobs.ParallelForRange(0, canvas.Height(), grain, [&](int rowBegin, int rowEnd) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            int spanMin, spanMax;
+            if (!canvas.TakeDirtySpan(row, spanMin, spanMax)) continue;
+
+            const int y {row + origin.y};
+            Colour *pixels {canvas.Row(row)};
+            std::fill(pixels + spanMin, pixels + spanMax, Colour(0, 0, 0)); // In case part of the row isn't in a room.
+
+            // A row of a room is contiguous in its colour plane, so each region's part of the span is a single copy.
+            for (const RoomRegion &region : regions) {
+                if (y < region.yMin || y >= region.yMax) continue;
+
+                const int xBegin {std::max(region.xMin, spanMin + origin.x)};
+                const int xEnd   {std::min(region.xMax, spanMax + origin.x)};
+                if (xBegin >= xEnd) continue;
+
+                const Colour *src {&region.room->grid.colour[region.room->ToIndex(xBegin, y)]};
+                std::copy(src, src + (xEnd - xBegin), pixels + (xBegin - origin.x));
+            }
+            canvas.MarkWritten(row, row + 1);
+        }
+    });
+}
+
+void Compositor::ComposeParticles(const std::vector<RoomRegion> &regions, sf::Vector2i origin) {
+    for (const RoomRegion &region : regions) {
+        ParticleSystem &particles {region.room->particles};
+        for (size_t i = 0; i < particles.Range(); ++i) {
+            sf::Vector2i position {particles.Position(i)};
+            // Only draw particles that are inside the view.
+            if (position.x < region.xMin || position.x >= region.xMax || position.y < region.yMin || position.y >= region.yMax)
+                continue;
+
+            sf::Vector2i p {position - origin};
+            canvas.SetPixel(p.x, p.y, particles.Colour(i));
+            drawnParticles.push_back(p);
+        }
+    }
+}
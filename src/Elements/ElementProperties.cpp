@@ -4,12 +4,29 @@
 #include "Utility/Random.hpp"
 #include <cmath>
 #include <fstream>
-#include <SFML/Graphics/Color.hpp>
 #include <SFML/System/Vector2.hpp>
+#include <utility>
 #include <vector>
 
 #define TEXTURE_INDEX 1
 
+namespace {
+
+    TextureLoader textureLoader;
+
+}
+
+void SetTextureLoader(TextureLoader loader) {
+    textureLoader = std::move(loader);
+}
+
+std::variant<std::vector<uint32_t>, Texture> TexturePalette(const std::string &path, uint32_t fallback) {
+    Texture texture;
+    if (textureLoader && textureLoader(path, texture) && texture.width > 0 && texture.height > 0) return texture;
+
+    return std::vector<uint32_t> {fallback};
+}
+
 ConstProperties::ConstProperties() :
     type(ElementType::AIR), name(), moveBehaviour(MoveType::NONE), spreadBehaviour(SpreadType::NONE), actionSet() {}
 
@@ -36,7 +53,7 @@ bool ElementProperties::Insert(Element id, ConstProperties consts, ColourPropert
 //  Colouring.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-sf::Color ElementProperties::Colour(Element id, int x, int y) const {
+Colour ElementProperties::Colour(Element id, int x, int y) const {
     if (HasTexture(id)) {
         return ColourFromTexture(id, x, y);
     } else {
@@ -44,22 +61,44 @@ sf::Color ElementProperties::Colour(Element id, int x, int y) const {
     }
 }
 
-sf::Color ElementProperties::ColourFromArray(Element id) const {
+int ElementProperties::PaletteIndex(Element id, ::Colour colour, int x, int y) const {
+    if (HasTexture(id)) {
+        return ColourFromTexture(id, x, y) == colour ? 0 : -1;
+    }
+
+    const std::vector<uint32_t> &palette {COLOUR(colours[id].palette)};
+    for (size_t i = 0; i < palette.size(); ++i) {
+        if (palette[i] == colour.ToInteger()) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+Colour ElementProperties::PaletteColour(Element id, int index, int x, int y) const {
+    if (HasTexture(id)) {
+        return ColourFromTexture(id, x, y);
+    }
+
+    const std::vector<uint32_t> &palette {COLOUR(colours[id].palette)};
+    if (index < 0 || index >= static_cast<int>(palette.size())) return Colour(id, x, y);
+    return ::Colour(palette[index]);
+}
+
+Colour ElementProperties::ColourFromArray(Element id) const {
     // No palette defaults to black
-    if (COLOUR(colours[id].palette).size() == 0) return sf::Color(0x00000000);
+    if (COLOUR(colours[id].palette).size() == 0) return ::Colour(0x00000000u);
 
     // Element is a single colour.
-    if (COLOUR(colours[id].palette).size() == 1) return sf::Color(COLOUR(colours[id].palette).at(0));
+    if (COLOUR(colours[id].palette).size() == 1) return ::Colour(COLOUR(colours[id].palette).at(0));
 
     int position {QuickRandInt(COLOUR(colours[id].palette).size())};
-    return sf::Color(COLOUR(colours[id].palette).at(position));
+    return ::Colour(COLOUR(colours[id].palette).at(position));
 }
 
-sf::Color ElementProperties::ColourFromTexture(Element id, int x, int y) const {
-    sf::Vector2u size {TEXTURE(colours[id].palette).getSize()};
-    x = x % static_cast<int>(size.x);
-    y = y % static_cast<int>(size.y);
-    return TEXTURE(colours[id].palette).getPixel(std::abs(x), std::abs(y));
+Colour ElementProperties::ColourFromTexture(Element id, int x, int y) const {
+    const Texture &texture {TEXTURE(colours[id].palette)};
+    x = x % static_cast<int>(texture.width);
+    y = y % static_cast<int>(texture.height);
+    return texture.At(std::abs(x), std::abs(y));
 }
 
 bool ElementProperties::HasTexture(Element id) const {
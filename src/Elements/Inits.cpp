@@ -24,9 +24,7 @@ bool InitStone(ElementProperties &properties) {
     constsInit.type     = ElementType::SOLID;
     constsInit.hardness = 50.f;
     ColourProperties colourInit;
-    sf::Image img;
-    img.loadFromFile("./assets/stone2-texture.png");
-    colourInit.palette  = img;
+    colourInit.palette  = TexturePalette("./assets/stone2-texture.png", 0x7f7f7fff);
 
     return properties.Insert(Element::stone, constsInit, colourInit);
 }
@@ -38,9 +36,7 @@ bool InitWood(ElementProperties &properties) {
     constsInit.flammability = 200.f;
     constsInit.hardness     = 15.f;
     ColourProperties colourInit;
-    sf::Image img;
-    img.loadFromFile("./assets/wood-texture.png");
-    colourInit.palette      = img;
+    colourInit.palette      = TexturePalette("./assets/wood-texture.png", 0x8b5a2bff);
 
     return properties.Insert(Element::wood, constsInit, colourInit);
 }
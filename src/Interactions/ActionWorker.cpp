@@ -1,51 +1,92 @@
 #include "Interactions/ActionWorker.hpp"
 #include "Utility/Random.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
-ActionWorker::ActionWorker(roomID_t id, SandWorld &_world, SandRoom *_room, ParticleWorker &_particles, float _dt) : 
-    InteractionWorker(id, _world, _room, _dt), particles(_particles), properties(_world.properties), grid(_room->grid) {}
+namespace {
+
+    constexpr float explosionRadius {25.5f};
+    constexpr float explosionForce  {100.f};
+    // Merged blasts push harder than a single explosion, up to this many times as hard.
+    constexpr float maxForceScale   {4.f};
+    // Each ray table covers blasts that reach up to this much further than the last.
+    constexpr int   blastReachStep  {4};
+
+    // A blast reaches explosionRadius past its furthest detonation. The rays for every reach that merging can 
+    // produce are traced once up front.
+    std::vector<RayTable> TraceBlastRays() {
+        std::vector<RayTable> tables;
+        for (int reach = 0; reach < 2 * ActionWorker::blastMergeReach + 2 * blastReachStep; reach += blastReachStep) {
+            tables.emplace_back(explosionRadius + reach);
+        }
+        return tables;
+    }
 
-bool ActionWorker::PerformActions(sf::Vector2i p, CellState &cell, ConstProperties &prop) {
-    if      (ActOnSelf (p, cell, prop)) { return true; } 
-    else if (ActOnOther(p, cell, prop)) { return true; }
+    const std::vector<RayTable> blastRays {TraceBlastRays()};
+
+    // Returns the rays of the smallest table that covers the given reach.
+    const RayTable &BlastRays(int reach) {
+        size_t table {static_cast<size_t>((reach + blastReachStep - 1) / blastReachStep)};
+        return blastRays[std::min(table, blastRays.size() - 1)];
+    }
 
-    return false;
 }
 
-void ActionWorker::ConsolidateActions() {
-    if (room->queuedActions.size() == 0) return;
+ActionWorker::ActionWorker(roomID_t id, SandWorld &_world, SandRoom *_room, ParticleWorker &_particles) : 
+    InteractionWorker(id, _world, _room), particles(_particles), properties(_world.properties), grid(_room->grid) {}
 
-    // Sort the queued actions by destination.
-    std::sort(room->queuedActions.begin(), room->queuedActions.end(), 
-        [](const std::pair<size_t, Element> &a, const std::pair<size_t, Element> &b) { 
-            return a.first < b.first;
-        }
-    );
+void ActionWorker::ReserveScratch(int numThreads) {
+    if (explosionScratch.size() < static_cast<size_t>(numThreads)) explosionScratch.resize(numThreads);
+    for (ExplosionScratch &scratch : explosionScratch) {
+        scratch.Resize(blastRays.back().Extent());
+    }
+}
 
-    // Used to catch the final action. 
-    room->queuedActions.emplace_back(-1, Element::null);
+void ActionWorker::ExplosionScratch::Resize(int _extent) {
+    if (extent == _extent) return;
 
-    int iStart {0};
+    extent = _extent;
+    const size_t side {static_cast<size_t>(2 * extent + 1)};
+    cells.assign(side * side, 0);
+    shockwave.assign(side * side, 0);
+    generation = 0;
+}
 
-    for (int i = 0; i < room->queuedActions.size() - 1; ++i) {
-        std::pair<size_t, Element> move       {room->queuedActions.at(i)};
-        std::pair<size_t, Element> nextMove   {room->queuedActions.at(i + 1)};
+void ActionWorker::ExplosionScratch::NextGeneration() {
+    if (++generation == 0) {
+        // The stamps have wrapped around, so the old ones could be mistaken for this generation's.
+        std::fill(cells.begin(), cells.end(), 0);
+        std::fill(shockwave.begin(), shockwave.end(), 0);
+        generation = 1;
+    }
+}
+
+bool ActionWorker::ExplosionScratch::Visit(std::vector<uint32_t> &stamps, sf::Vector2i offset) {
+    uint32_t &stamp {stamps[(offset.y + extent) * (2 * extent + 1) + offset.x + extent]};
+    if (stamp == generation) return false;
+    stamp = generation;
+    return true;
+}
 
-        if (move.first != nextMove.first) {
-            // Perform the randomly-selected action from the competing actions group.
-            int iRand {iStart + QuickRandInt(i - iStart)};
-            
-            size_t iCell {room->queuedActions[iRand].first};
-            Element tfID {room->queuedActions[iRand].second};
-            grid.Assign(iCell, tfID);
+bool ActionWorker::PerformActions(sf::Vector2i p, CellState &cell, ConstProperties &prop) {
+    if      (ActOnSelf (p, cell, prop)) { return true; } 
+    else if (ActOnOther(p, cell, prop)) { return true; }
 
-            sf::Vector2i coords {room->ToWorldCoords(iCell)};
+    return false;
+}
+
+void ActionWorker::ConsolidateActions(ConflictResolver &resolver) {
+    const bool counting {world.TelemetryWindow() > 0};
+    resolver.Resolve(room->queuedActions, 
+        [](const Action &action) { return action.Index(); },
+        [this, counting](const Action &action) {
+            grid.Assign(action.Index(), action.Transform());
+
+            sf::Vector2i coords {room->ToWorldCoords(action.Index())};
             room->chunks.KeepContainingAlive(coords.x, coords.y);
-        
-            iStart = i + 1;
-        }
-    }
+            if (counting) ++room->chunks.GetContainingChunk(coords.x, coords.y).activity.actions;
+        });
 
     room->queuedActions.clear();
 }
@@ -98,8 +139,8 @@ bool ActionWorker::SandActOnOther(sf::Vector2i p, CellState &cell, ConstProperti
         size_t other        = otherRoom->ToIndex(otherP);
 
         if (otherRoom->GetCell(other).id == Element::fire) {
-            room->QueueAction(self, Element::air);
-            otherRoom->QueueAction(other, Element::sand);
+            QueueAction(room, self, Element::air);
+            QueueAction(otherRoom, other, Element::sand);
             return true;
         }
     }
@@ -119,8 +160,8 @@ bool ActionWorker::WaterActOnOther(sf::Vector2i p, CellState &cell, ConstPropert
         size_t other        = otherRoom->ToIndex(otherP);
 
         if (otherRoom->GetCell(other).id == Element::fire) {
-            room->QueueAction(self, Element::smoke);
-            otherRoom->QueueAction(other, Element::water);
+            QueueAction(room, self, Element::smoke);
+            QueueAction(otherRoom, other, Element::water);
             return true;
         }
     }
@@ -135,9 +176,9 @@ bool ActionWorker::FireActOnSelf(sf::Vector2i p, CellState &cell, ConstPropertie
 
     if (cell.health <= 0) {
         if (Probability(20))
-            room->QueueAction(self, Element::smoke);
+            QueueAction(room, self, Element::smoke);
         else
-            room->QueueAction(self, Element::air);
+            QueueAction(room, self, Element::air);
 
         return true;
     }
@@ -159,14 +200,14 @@ bool ActionWorker::FireActOnOther(sf::Vector2i p, CellState &cell, ConstProperti
         if (VALID_ROOM(roomID)) {
             SandRoom  *otherRoom = GetRoom(roomID);
             size_t     other     = otherRoom->ToIndex(otherP);
-            CellState &otherCell = otherRoom->GetCell(other);
+            CellState otherCell {otherRoom->GetCell(other)};
 
             // Action code.
             float flammability = properties.constants[otherCell.id].flammability;
             if (flammability > 0.f) {
                 cell.health += flammability * dt;
                 if (otherCell.health <= 0.f)
-                    otherRoom->QueueAction(other, Element::fire);
+                    QueueAction(otherRoom, other, Element::fire);
                 else
                     otherCell.health -= flammability * dt;
 
@@ -182,7 +223,7 @@ bool ActionWorker::SmokeActOnSelf(sf::Vector2i p, CellState &cell, ConstProperti
     size_t self = room->ToIndex(p);
 
     if (cell.health <= 0) {
-        room->QueueAction(self, Element::air);
+        QueueAction(room, self, Element::air);
     }
 
     cell.health -= (100.f + static_cast<float>(QuickRandRange(-50, 50))) * dt;
@@ -195,7 +236,7 @@ bool ActionWorker::SparkActOnSelf(sf::Vector2i p, CellState &cell, ConstProperti
     size_t self = room->ToIndex(p);
 
     if (cell.health <= 0) {
-        room->QueueAction(self, Element::air);
+        QueueAction(room, self, Element::air);
         return true;
     }
 
@@ -208,49 +249,39 @@ bool ActionWorker::SparkActOnSelf(sf::Vector2i p, CellState &cell, ConstProperti
     return false;   
 }
 
-void ActionWorker::ExplodeRadius(sf::Vector2i pCentre, sf::Vector2i pRadius, float force, 
-    cached_points &cachedCells, cached_points &cachedShockwave) {
-    // Set up the variables for a supercover line.
-    int dx      = pRadius.x - pCentre.x,    dy      = pRadius.y - pCentre.y;    // The difference in point positions.
-    float nx    = std::abs(dx),             ny      = std::abs(dy);             // The number of grid spaces to move.
-    int sgnx    = (dx > 0) - (dx < 0),      sgny    = (dy > 0) - (dy < 0);      // The direction to step.
+void ActionWorker::ExplodeRay(sf::Vector2i pCentre, const RayTable &rays, const RayTable::Ray &ray, float force, int reach,
+    ExplosionScratch &scratch) {
     // The current room that the explosion is occuring in.
     SandRoom *explosionRoom {room};
     // The direction that the explosion is travelling.
-    sf::Vector2f dir {pRadius - pCentre};
-    dir *= (1.f / std::sqrtf(dir.x * dir.x + dir.y * dir.y));
-
-    // Lambda expression for stepping towards the explosion radius.
-    auto updateStep = [nx, ny, sgnx, sgny](sf::Vector2i point, int &x, int &y) {
-        if ((0.5 + x) / nx < (0.5 + y) / ny) {
-            // Take a horizontal step.
-            point.x += sgnx;
-            x++;
-        } else {
-            // Take a vertical step.
-            point.y += sgny;
-            y++;
-        }
-        return point;
-    };
+    const sf::Vector2f dir {ray.direction};
 
-    sf::Vector2i point {pCentre}; // The point of the explosion.
-         // The number of x and y steps that have been taken.
+    sf::Vector2i point {pCentre + ray.target}; // The point of the explosion, which ends up wherever it stops.
     bool dampened = false;  // Whether or not the explosion was stopped by something.
     // Step through the destructive distance of the explosion.
-    for (int ix = 0, iy = 0; ix < nx || iy < ny; point = updateStep(point, ix, iy)) {
-        if (cachedCells.find(point) != cachedCells.end()) { continue; } // Ignore cells that have been exploded already.
-        cachedCells.insert(point); // Add to the set so we don't repeat actions on this cell.
+    for (uint32_t i = ray.begin; i < ray.end; ++i) {
+        const sf::Vector2i offset {rays.Offset(i)};
+        if (!scratch.Visit(scratch.cells, offset)) { continue; } // Ignore cells that have been exploded already.
         
         // Account for explosions crossing rooms.
-        roomID_t newRoomID = ContainingRoomID(point);
+        const sf::Vector2i cellPoint {pCentre + offset};
+        roomID_t newRoomID = ContainingRoomID(cellPoint);
         if (!VALID_ROOM(newRoomID)) { return; } // No need to spawn new rooms, as an invalid room implies it's empty (nothing to explode).
         explosionRoom = GetRoom(newRoomID);
+        const size_t cellIndex = explosionRoom->ToIndex(cellPoint);
+
+        // Explosion cells outside of the blast go off next step, rather than being destroyed.
+        const bool inside {rays.Ring(i) <= reach};
+        if (!inside && explosionRoom->grid.Id(cellIndex) == Element::explosion) {
+            explosionRoom->chunks.KeepContainingAlive(cellPoint.x, cellPoint.y);
+            continue;
+        }
 
-        // Dampen the explosion when it hits hard elements.
-        const ConstProperties &prop = GetProperties(point);
-        force -= prop.hardness;
+        // Dampen the explosion when it hits hard elements. Nothing within the reach of the detonations holds it back.
+        const ConstProperties &prop = explosionRoom->grid.GetProperties(cellIndex);
+        if (!inside) force -= prop.hardness;
         if (force <= 0.f) {
+            point = cellPoint;
             dampened = true;
             break;
         }
@@ -258,73 +289,74 @@ void ActionWorker::ExplodeRadius(sf::Vector2i pCentre, sf::Vector2i pRadius, flo
         // Chance to destroy - Always destroy immovable elements.
         if (Probability(60) || prop.Immoveable()) {
             if (Probability(80))
-                explosionRoom->QueueAction(explosionRoom->ToIndex(point), Element::air);
+                QueueAction(explosionRoom, cellIndex, Element::air);
             else
-                explosionRoom->QueueAction(explosionRoom->ToIndex(point), Element::spark);
+                QueueAction(explosionRoom, cellIndex, Element::spark);
         // Chance to throw debris.
         } else {
             if (Probability(5)) { // Shoot sparks out that can catch fire.
-                particles.BecomeParticle(point, (force + QuickRandInt(2 * force)) * dir,
+                particles.BecomeParticle(cellPoint, (force + QuickRandInt(2 * force)) * dir,
                     Element::fire, properties.Colour(Element::fire));
 
             } else if (prop.Moveable()) { // Shoot moveable debris around.
-                size_t cellIndex = explosionRoom->ToIndex(point);
-
-                particles.BecomeParticle(point, (force + QuickRandInt(2 * force)) * dir,
-                    grid.state[cellIndex].id, grid.colour[cellIndex]);
+                particles.BecomeParticle(cellPoint, (force + QuickRandInt(2 * force)) * dir,
+                    explosionRoom->grid.Id(cellIndex), explosionRoom->grid.colour[cellIndex]);
             }
         }
     }
 
-    int shockwaveRadius = RandInt(std::max(nx, ny) / 2);
+    int shockwaveRadius = RandInt(ray.extensionLimit);
     // Extend a shockwave past the immediate destructive radius.
-    for (int ix = 0, iy = 0; ix < shockwaveRadius && iy < shockwaveRadius; point = updateStep(point, ix, iy)) {
-        roomID_t newRoomID = ContainingRoomID(point);
+    for (uint32_t i = ray.extensionBegin; i < ray.extensionEnd && rays.Ring(i) < shockwaveRadius; ++i) {
+        const sf::Vector2i shockPoint {point + rays.Offset(i)};
+        roomID_t newRoomID = ContainingRoomID(shockPoint);
         if (!VALID_ROOM(newRoomID)) { return; } // No need to spawn new rooms, as an invalid room implies it's empty (nothing to explode).
 
         explosionRoom = GetRoom(newRoomID);
 
-        if (cachedShockwave.find(point) != cachedShockwave.end()) { continue; } // Ignore cells that have been exploded already.
-        cachedShockwave.insert(point); // Add to the set so we don't repeat actions on this cell.
+        if (!scratch.Visit(scratch.shockwave, shockPoint - pCentre)) { continue; } // Ignore cells that have been exploded already.
 
-        const ConstProperties &prop = GetProperties(point);
+        const size_t cellIndex = explosionRoom->ToIndex(shockPoint);
+        const ConstProperties &prop = explosionRoom->grid.GetProperties(cellIndex);
         // Darken immovable elements to create scorch marks.
         if (prop.Immoveable()) {
-            explosionRoom->grid.Darken(explosionRoom->ToIndex(point));
+            explosionRoom->grid.Darken(cellIndex);
+            explosionRoom->chunks.KeepContainingAlive(shockPoint.x, shockPoint.y); // So that the scorch mark is redrawn.
             continue;
         }
         if (dampened) { continue; } // If the explosion has been dampened, there is no need to throw debris.
 
         // Throw moveable elements as debris.
         if (prop.Moveable()) {
-            size_t cellIndex = explosionRoom->ToIndex(point);
-
-            particles.BecomeParticle(point, (force + QuickRandInt(2 * force)) * dir,
-                grid.state[cellIndex].id, grid.colour[cellIndex]);
+            particles.BecomeParticle(shockPoint, (force + QuickRandInt(2 * force)) * dir,
+                explosionRoom->grid.Id(cellIndex), explosionRoom->grid.colour[cellIndex]);
         }
     }
 }
 
 bool ActionWorker::ExplosionActOnSelf(sf::Vector2i p, CellState &cell, ConstProperties &prop) {
-    float radius {25.5};
-    cached_points cachedCells;
-    cached_points cachedShockwave;
-    float force {100.f};
-    for (int h = 0; h <= std::round(radius * std::sqrtf(0.5f)); ++h) {
-        int b {static_cast<int>(std::round(std::sqrtf(radius * radius - h * h)))};
-
-        // The circumference calculation can be repeated for each octant.
-        ExplodeRadius(p, sf::Vector2i(p.x + b, p.y + h), force, cachedCells, cachedShockwave);
-        ExplodeRadius(p, sf::Vector2i(p.x - b, p.y + h), force, cachedCells, cachedShockwave);
-        ExplodeRadius(p, sf::Vector2i(p.x + b, p.y - h), force, cachedCells, cachedShockwave);
-        ExplodeRadius(p, sf::Vector2i(p.x - b, p.y - h), force, cachedCells, cachedShockwave);
-        ExplodeRadius(p, sf::Vector2i(p.x + h, p.y + b), force, cachedCells, cachedShockwave);
-        ExplodeRadius(p, sf::Vector2i(p.x - h, p.y + b), force, cachedCells, cachedShockwave);
-        ExplodeRadius(p, sf::Vector2i(p.x + h, p.y - b), force, cachedCells, cachedShockwave);
-        ExplodeRadius(p, sf::Vector2i(p.x - h, p.y - b), force, cachedCells, cachedShockwave);
+    // The explosion is resolved once the step's detonations have been merged into blasts.
+    explosionScratch[world.Jobs().ThisWorker()].detonations.push_back(p);
+    return true;
+}
+
+void ActionWorker::TakeDetonations(std::vector<sf::Vector2i> &detonations) {
+    for (ExplosionScratch &scratch : explosionScratch) {
+        detonations.insert(detonations.end(), scratch.detonations.begin(), scratch.detonations.end());
+        scratch.detonations.clear();
     }
+}
 
-    return true;
+void ActionWorker::Explode(const Blast &blast) {
+    ExplosionScratch &scratch {explosionScratch[world.Jobs().ThisWorker()]};
+    scratch.NextGeneration();
+
+    const RayTable &rays {BlastRays(blast.reach)};
+    // Merged blasts push harder, though not in proportion to their size, so that debris isn't flung out of sight.
+    const float force {explosionForce * std::min(std::sqrt(static_cast<float>(blast.detonations)), maxForceScale)};
+    for (const RayTable::Ray &ray : rays.Rays()) {
+        ExplodeRay(blast.centre, rays, ray, force, blast.reach, scratch);
+    }
 }
 
 bool ActionWorker::ExplosionActOnOther(sf::Vector2i p, CellState &cell, ConstProperties &prop) {
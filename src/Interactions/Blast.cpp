@@ -0,0 +1,64 @@
+#include "Interactions/Blast.hpp"
+#include "Utility/Hashes.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+std::vector<Blast> MergeDetonations(std::vector<sf::Vector2i> detonations, int maxReach) {
+    std::sort(detonations.begin(), detonations.end(), [](sf::Vector2i a, sf::Vector2i b) {
+        return a.y < b.y || (a.y == b.y && a.x < b.x);
+    });
+
+    // The origins are bucketed on a grid of maxReach-sized cells, so only the surrounding buckets are searched.
+    auto bucketOf {[maxReach](sf::Vector2i p) {
+        return sf::Vector2i(static_cast<int>(std::floor(static_cast<float>(p.x) / maxReach)),
+                            static_cast<int>(std::floor(static_cast<float>(p.y) / maxReach)));
+    }};
+    std::unordered_map<sf::Vector2i, std::vector<int>, Vector2iHash> buckets;
+    const int maxReach2 {maxReach * maxReach};
+
+    std::vector<Blast>          blasts;
+    std::vector<sf::Vector2i>   sums;       // The sum of the positions of each blast's detonations.
+    std::vector<int>            membership; // The blast that each detonation joined.
+    membership.reserve(detonations.size());
+    for (sf::Vector2i p : detonations) {
+        const sf::Vector2i bucket {bucketOf(p)};
+        int joined {-1};
+        for (int dy = -1; dy <= 1 && joined < 0; ++dy) {
+            for (int dx = -1; dx <= 1 && joined < 0; ++dx) {
+                auto it {buckets.find(bucket + sf::Vector2i(dx, dy))};
+                if (it == buckets.end()) continue;
+                for (int b : it->second) {
+                    const sf::Vector2i d {p - blasts[b].origin};
+                    if (d.x * d.x + d.y * d.y <= maxReach2) {
+                        joined = b;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (joined < 0) {
+            joined = static_cast<int>(blasts.size());
+            blasts.push_back(Blast {p, p, 0, 0});
+            sums.emplace_back(0, 0);
+            buckets[bucket].push_back(joined);
+        }
+        blasts[joined].detonations++;
+        sums[joined] += p;
+        membership.push_back(joined);
+    }
+
+    for (size_t b = 0; b < blasts.size(); ++b) {
+        blasts[b].centre = sf::Vector2i(
+            static_cast<int>(std::lround(static_cast<float>(sums[b].x) / blasts[b].detonations)),
+            static_cast<int>(std::lround(static_cast<float>(sums[b].y) / blasts[b].detonations)));
+    }
+    for (size_t i = 0; i < detonations.size(); ++i) {
+        Blast &blast {blasts[membership[i]]};
+        const sf::Vector2i d {detonations[i] - blast.centre};
+        blast.reach = std::max(blast.reach, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(d.x * d.x + d.y * d.y)))));
+    }
+
+    return blasts;
+}
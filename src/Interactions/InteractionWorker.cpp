@@ -1,12 +1,25 @@
 #include "Interactions/InteractionWorker.hpp"
 #include "Utility/Line.hpp"
 
-inline roomID_t BoolToID(roomID_t id, bool valid) {
-    return (id * valid) + (valid - 1); // Should map (valid == true) -> id and (valid == false) -> -1.
+InteractionWorker::InteractionWorker(roomID_t id, SandWorld &_world, SandRoom *_room) :
+    thisID(id), world(_world), room(_room), dt(0.f) {}
+
+thread_local Outbox *InteractionWorker::outbox {nullptr};
+
+void InteractionWorker::QueueMovement(SandRoom *dstRoom, sf::Vector2i src, sf::Vector2i dst) {
+    // Cells never move this far in one step unless the timestep is huge, in which case the move is dropped.
+    if (!Move::Fits(src - dst)) return;
+
+    outbox->moves[Outbox::Slot(*room, *dstRoom)].emplace_back(dstRoom->ToIndex(dst), src - dst);
+}
+
+void InteractionWorker::QueueAction(SandRoom *dstRoom, size_t i, Element transform) {
+    outbox->actions[Outbox::Slot(*room, *dstRoom)].emplace_back(i, transform);
 }
 
-InteractionWorker::InteractionWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt) :
-    thisID(id), world(_world), room(_room), dt(_dt) {}
+void InteractionWorker::QueueParticle(SandRoom *dstRoom, const Particle &particle, sf::Vector2f F) {
+    outbox->launches[Outbox::Slot(*room, *dstRoom)].push_back(Launch {particle, F});
+}
 
 void InteractionWorker::KeepContainingAlive(int x, int y) {
     room->chunks.KeepContainingAlive(x, y);
@@ -14,23 +27,17 @@ void InteractionWorker::KeepContainingAlive(int x, int y) {
 }
 
 void InteractionWorker::KeepNeighbourAlive(int x, int y) {
-    if (x == room->x)                   
-        x -= 1;
-    else if (x == room->x + room->width - 1) 
-        x += 1;
-
-    if (y == room->y)
-        y -= 1;
-    else if (y == room->y + room->height - 1) 
-        y += 1;
-
-    roomID_t id {ContainingRoomID(sf::Vector2i{x, y})};
-    if (id != thisID && VALID_ROOM(id)) {
-        world.GetRoom(id).chunks.KeepContainingAlive(x, y);
+    const int dx {(x == room->x + room->width - 1)  - (x == room->x)};
+    const int dy {(y == room->y + room->height - 1) - (y == room->y)};
+    if (dx == 0 && dy == 0) return;
+
+    SandRoom *neighbour {room->Neighbour(SandRoom::NeighbourSlot(dx, dy))};
+    if (neighbour) {
+        neighbour->chunks.KeepContainingAlive(x + dx, y + dy);
     }
 }
 
-CellState& InteractionWorker::GetCell(int x, int y) {
+CellState InteractionWorker::GetCell(int x, int y) {
     if (room->InBounds(x, y)) {
         return room->GetCell(x, y);
     }
@@ -38,7 +45,7 @@ CellState& InteractionWorker::GetCell(int x, int y) {
     return world.GetCell(x, y);
 }
 
-CellState& InteractionWorker::GetCell(sf::Vector2i p) {
+CellState InteractionWorker::GetCell(sf::Vector2i p) {
     return GetCell(p.x, p.y);
 }
 
@@ -74,6 +81,10 @@ roomID_t InteractionWorker::ContainingRoomID(sf::Vector2i p) {
     if (room->InBounds(p)) {
         return thisID;
     }
+    if (room->Adjacent(p)) {
+        SandRoom *neighbour {room->NeighbourContaining(p)};
+        return neighbour ? neighbour->id : -1;
+    }
 
     return world.ContainingRoomID(p);
 }
@@ -82,6 +93,11 @@ SandRoom* InteractionWorker::GetRoom(roomID_t id) {
     if (id == thisID) {
         return room;
     }
+    // Most rooms other than this one are its neighbours, which can be found without going through the world.
+    for (int slot = 0; slot < SandRoom::numNeighbourSlots; ++slot) {
+        SandRoom *neighbour {room->Neighbour(slot)};
+        if (neighbour && neighbour->id == id) return neighbour;
+    }
 
     return &world.GetRoom(id);
 }
@@ -95,6 +111,10 @@ roomID_t InteractionWorker::IsEmpty(sf::Vector2i p) {
         bool empty {room->IsEmpty(p)};
         return BoolToID(thisID, empty); // Should map empty -> thisID and !empty -> -1.
     }
+    if (room->Adjacent(p)) {
+        SandRoom *neighbour {room->NeighbourContaining(p)};
+        return neighbour && neighbour->IsEmpty(p) ? neighbour->id : -1;
+    }
 
     return world.EmptyRoom(p);
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 #include "Utility/Physics.hpp"
 #include "Utility/Random.hpp"
 
-MovementWorker::MovementWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt) : InteractionWorker(id, _world, _room, _dt) {}
+MovementWorker::MovementWorker(roomID_t id, SandWorld &_world, SandRoom *_room) : InteractionWorker(id, _world, _room) {}
 
 bool MovementWorker::PerformMovement(sf::Vector2i p, CellState &cell, ConstProperties &prop) {
     if      (  MoveCell(p, cell, prop)) { return true; }  // Apply movement behaviours (falling, floating, etc).
@@ -11,50 +11,49 @@ bool MovementWorker::PerformMovement(sf::Vector2i p, CellState &cell, ConstPrope
     return false;
 }
 
-void MovementWorker::ConsolidateMovement() {
-    if (room->queuedMoves.size() == 0) return;
-
-    // Remove moves that have had their destination filled between frames.
-    // TODO. Will probably be needed for threading?
-
-    // Sort moves by source rooms then by destination.
-    std::sort(room->queuedMoves.begin(), room->queuedMoves.end(), 
-        [](const Move &a, const Move &b) { return a.dst < b.dst; }
-    );
-    
-    // As the vector is sorted, this end object is guaranteed to be different to any other element.
-    room->queuedMoves.emplace_back();
-
-    int iStart {0};
-
-    for (int i = 0; i < room->queuedMoves.size() - 1; ++i) {
-        Move move       {room->queuedMoves.at(i)};
-        Move nextMove   {room->queuedMoves.at(i + 1)};
-
-        if (move.dst != nextMove.dst) {
-            // Perform the randomly-selected move from the competing moves group.
-            int iRand {iStart + QuickRandInt(i - iStart)};
-            
-            roomID_t id {room->queuedMoves[iRand].srcRoomID};
-            int src     {room->queuedMoves[iRand].src};
-            int dst     {room->queuedMoves[iRand].dst};
-            
-            SandRoom *srcRoom {GetRoom(id)};
-            std::swap(srcRoom->grid.state[src], room->grid.state[dst]);
-            std::swap(srcRoom->grid.colour[src], room->grid.colour[dst]);
-
-            sf::Vector2i srcCoords {srcRoom->ToWorldCoords(src)};
-            sf::Vector2i dstCoords {   room->ToWorldCoords(dst)};
-            srcRoom->chunks.KeepContainingAlive(srcCoords.x, srcCoords.y);
-               room->chunks.KeepContainingAlive(dstCoords.x, dstCoords.y);
-
-            iStart = i + 1;
+void MovementWorker::ConsolidateMovement(ConflictResolver &resolver) {
+    // With telemetry enabled, every move counts as lost until it wins its destination.
+    const bool counting {world.TelemetryWindow() > 0};
+    if (counting) {
+        for (const Move &move : room->queuedMoves) {
+            sf::Vector2i dstCoords {room->ToWorldCoords(move.Dst())};
+            ++room->chunks.GetContainingChunk(dstCoords.x, dstCoords.y).activity.lost;
         }
     }
 
+    resolver.Resolve(room->queuedMoves, 
+        [](const Move &move) { return move.Dst(); },
+        [this, counting](const Move &move) {
+            sf::Vector2i dstCoords {room->ToWorldCoords(move.Dst())};
+            if (counting) --room->chunks.GetContainingChunk(dstCoords.x, dstCoords.y).activity.lost;
+            if (room->InBounds(dstCoords + move.Offset())) {
+                ApplyMove(move);
+            } else {
+                deferredMoves.push_back(move);
+            }
+        });
+
     room->queuedMoves.clear();
 }
 
+void MovementWorker::ApplyDeferredMoves() {
+    for (const Move &move : deferredMoves) {
+        ApplyMove(move);
+    }
+    deferredMoves.clear();
+}
+
+void MovementWorker::ApplyMove(const Move &move) {
+    sf::Vector2i dstCoords {room->ToWorldCoords(move.Dst())};
+    sf::Vector2i srcCoords {dstCoords + move.Offset()};
+    // Most moves start in this room, which saves looking the source room up.
+    SandRoom *srcRoom {room->InBounds(srcCoords) ? room : GetRoom(ContainingRoomID(srcCoords))};
+    srcRoom->grid.Swap(srcRoom->ToIndex(srcCoords), room->grid, move.Dst());
+
+    srcRoom->chunks.KeepContainingAlive(srcCoords.x, srcCoords.y);
+       room->chunks.KeepContainingAlive(dstCoords.x, dstCoords.y);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //  High-level behaviour.
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -89,15 +88,12 @@ bool MovementWorker::FloatDown(sf::Vector2i p) {
     sf::Vector2i queryPos(p.x, p.y - 1);
     // Handle the destination crossing rooms.
     if (room->IsEmpty(queryPos)) {
-        room->QueueMovement(thisID, room->ToIndex(p.x, p.y), 
-                                room->ToIndex(queryPos.x, queryPos.y));
+        QueueMovement(room, p, queryPos);
         return true;
     }
-    roomID_t id {world.EmptyRoom(queryPos)};
+    roomID_t id {IsEmpty(queryPos)};
     if (VALID_ROOM(id)) {
-        SandRoom &dstRoom {world.GetRoom(id)};
-        dstRoom.QueueMovement(thisID, room->ToIndex(p.x, p.y),
-                                dstRoom.ToIndex(queryPos.x, queryPos.y));
+        QueueMovement(GetRoom(id), p, queryPos);
         return true;
     }
 
@@ -110,7 +106,7 @@ bool MovementWorker::FloatUp(sf::Vector2i p) {
 
 bool MovementWorker::FallDown(sf::Vector2i p) {
     size_t iCell    = CellIndex(p);
-    CellState &cell = room->GetCell(iCell);
+    CellState cell {room->GetCell(iCell)};
 
     cell.ApplyAcceleration(constants::accelGravity, dt);
     sf::Vector2i deltaP {AccelerateProbability(cell.velocity, dt)};
@@ -121,8 +117,7 @@ bool MovementWorker::FallDown(sf::Vector2i p) {
 
     if (VALID_ROOM(roomID)) {
         SandRoom *dstRoom = GetRoom(roomID);
-        dstRoom->QueueMovement(thisID, room->ToIndex(p.x, p.y), 
-                                dstRoom->ToIndex(dst.x, dst.y));
+        QueueMovement(dstRoom, p, dst);
         return true;
     }
 
@@ -155,17 +150,17 @@ bool MovementWorker::SpreadDownSide(sf::Vector2i p) {
 
     // If both left and right are open / displaceable spaces, randomly select one.
     if (VALID_ROOM(left) && VALID_ROOM(right)) {
-        bool flip = Probability(50);
+        bool flip = CoinFlip();
         left    = BoolToID( left,  flip);
         right   = BoolToID(right, !flip);
     }
 
     if (VALID_ROOM(left)) {
         SandRoom *dstRoom = GetRoom( left);
-        dstRoom->QueueMovement(thisID, room->ToIndex(p), dstRoom->ToIndex( leftPos));
+        QueueMovement(dstRoom, p, leftPos);
     } else if (VALID_ROOM(right)) {
         SandRoom *dstRoom = GetRoom(right);
-        dstRoom->QueueMovement(thisID, room->ToIndex(p), dstRoom->ToIndex(rightPos));
+        QueueMovement(dstRoom, p, rightPos);
     }
 
     return VALID_ROOM(left) || VALID_ROOM(right);
@@ -180,17 +175,17 @@ bool MovementWorker::SpreadUpSide(sf::Vector2i p) {
 
     // If both left and right are open spaces, randomly select one.
     if (VALID_ROOM(left) && VALID_ROOM(right)) {
-        bool flip = Probability(50);
+        bool flip = CoinFlip();
         left    = BoolToID( left,  flip);
         right   = BoolToID(right, !flip);
     }
 
     if (VALID_ROOM(left)) {
         SandRoom *dstRoom = GetRoom(left);
-        dstRoom->QueueMovement(thisID, room->ToIndex(p), dstRoom->ToIndex(leftPos));
+        QueueMovement(dstRoom, p, leftPos);
     } else if (VALID_ROOM(right)) {
         SandRoom *dstRoom = GetRoom(right);
-        dstRoom->QueueMovement(thisID, room->ToIndex(p), dstRoom->ToIndex(rightPos));
+        QueueMovement(dstRoom, p, rightPos);
     }
 
     return VALID_ROOM(left) || VALID_ROOM(right);
@@ -205,17 +200,17 @@ bool MovementWorker::SpreadSide(sf::Vector2i p) {
 
     // Need to account for whether it's left OR right that gives a VALID_ROOM;
     if (VALID_ROOM(left) && VALID_ROOM(right)) {
-        bool flip {Probability(50)};
+        bool flip {CoinFlip()};
         left    = BoolToID( left,  flip);
         right   = BoolToID(right, !flip);
     }
     
     if (VALID_ROOM(left)) {
         SandRoom *dstRoom = GetRoom( left);
-        dstRoom->QueueMovement(thisID, room->ToIndex(p), dstRoom->ToIndex(leftDst));
+        QueueMovement(dstRoom, p, leftDst);
     } else if (VALID_ROOM(right)) {
         SandRoom *dstRoom = GetRoom(right);
-        dstRoom->QueueMovement(thisID, room->ToIndex(p), dstRoom->ToIndex(rightDst));
+        QueueMovement(dstRoom, p, rightDst);
     }
 
     return VALID_ROOM(left) || VALID_ROOM(right);
@@ -2,81 +2,114 @@
 #include "Interactions/ParticleWorker.hpp"
 #include "Utility/Line.hpp"
 #include "Utility/Physics.hpp"
+#include <algorithm>
 
-ParticleWorker::ParticleWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt) :
-    InteractionWorker(id, _world, _room, _dt), properties(_world.properties) {}
+ParticleWorker::ParticleWorker(roomID_t id, SandWorld &_world, SandRoom *_room) :
+    InteractionWorker(id, _world, _room), properties(_world.properties) {}
 
-void ParticleWorker::BecomeParticle(sf::Vector2i p, sf::Vector2f F, Element id, sf::Color colour) {
+void ParticleWorker::BecomeParticle(sf::Vector2i p, sf::Vector2f F, Element id, Colour colour) {
     SandRoom *particleRoom = GetRoom(ContainingRoomID(p));
 
     // Remove the cell from the grid.
     size_t cellIndex = particleRoom->ToIndex(p);
-    particleRoom->QueueAction(particleRoom->ToIndex(p), Element::air);
+    QueueAction(particleRoom, particleRoom->ToIndex(p), Element::air);
 
-    // Add the particle to the system.
-    Particle particle {id, p, colour};
-    particleRoom->particles.AddParticle(particle, F);
-}
-
-void ParticleWorker::BecomeCell(size_t index) {
-    // Convert the particle to a cell in the grid.
-    sf::Vector2i p {room->particles[index].Position()};
-    room->grid.Assign(
-        room->ToIndex(p), 
-        room->particles[index].id,
-        room->particles[index].colour);
-    // Remove the particle from the system.
-    room->particles.RemoveParticle(index);
-    KeepContainingAlive(p.x, p.y);
+    // Add the particle to the system once the step's outboxes are delivered.
+    QueueParticle(particleRoom, Particle {id, p, colour}, F);
 }
 
 void ParticleWorker::ProcessParticles() {
-    for (int i = 0; i < room->particles.Range(); i++) {
-        Particle &particle {room->particles[i]};
-        sf::Vector2i oldP {particle.Position()};
-        particle.Integrate(dt);
+    ParticleSystem &particles {room->particles};
+    const size_t count {particles.Range()};
+    // Every particle is integrated at once, and then walked along its path from where it was.
+    oldPositions.clear();
+    for (size_t i = 0; i < count; ++i) {
+        oldPositions.push_back(particles.Position(i));
+    }
+    particles.Integrate(dt, world.ParticleIntegrator());
 
-        sf::Vector2i    dst;
-        roomID_t        roomID;
-        SandRoom       *dstRoom;
-        bool collision = false;
-        Lerp line {oldP, particle.Position()};
-        for (Lerp::iterator lineIt = ++line.begin(); lineIt != line.end(); ++lineIt) {
-            dst = *lineIt;
-            roomID = ContainingRoomID(dst);
-            if (!VALID_ROOM(roomID) && world.InBounds(dst)) {
-                roomID = world.SpawnRoom(dst.x, dst.y);
-            } else if (!VALID_ROOM(roomID)) {
-                --lineIt;
-                particle.Position(*lineIt);
-                roomID = ContainingRoomID(dst);
-                collision = true;
-                break;
-            }
+    landings.clear();
+    migrations.clear();
+    leaving.assign(count, 0);
 
-            // Account for particles crossing rooms.
-            dstRoom = GetRoom(roomID);
-            if (roomID != thisID) {
-                dstRoom->particles.AddParticle(particle);
-                room->particles.RemoveParticle(i);
-                i--;
-                break;
+    for (size_t i = 0; i < count; ++i) {
+        // Walk every cell that the path passes through. The room is only looked up again when the path leaves
+        // the one that it's in.
+        SandRoom       *pathRoom {room};
+        SandRoom       *lastRoom {room};
+        sf::Vector2i    last {oldPositions[i]};
+        bool collision {false};
+        Lerp path {last, particles.Position(i)};
+        for (Lerp::iterator it = ++path.begin(); it != path.end(); ++it) {
+            const sf::Vector2i p {*it};
+            if (!pathRoom->InBounds(p)) {
+                roomID_t roomID {ContainingRoomID(p)};
+                if (!VALID_ROOM(roomID) && world.InBounds(p)) {
+                    roomID = world.SpawnRoom(p.x, p.y);
+                }
+                if (!VALID_ROOM(roomID)) {
+                    collision = true;
+                    break;
+                }
+                pathRoom = GetRoom(roomID);
             }
 
-            if (!dstRoom->IsEmpty(dst)) {
-                --lineIt;
-                particle.Position(*lineIt);
-                roomID = ContainingRoomID(dst);
+            if (!pathRoom->IsEmpty(p)) {
                 collision = true;
                 break;
             }
+            last = p;
+            lastRoom = pathRoom;
         }
 
         // The path to the particle's destination contains a collision, 
-        // therefore convert the particle to a cell.
+        // therefore the particle becomes a cell in the last free cell along it.
         if (collision) {
-            BecomeCell(i);
-            i--;
+            BecomeCell(i, lastRoom, last);
+        } else if (pathRoom != room) {
+            migrations.push_back(Migration {i, pathRoom});
+            leaving[i] = 1;
         }
     }
-}
\ No newline at end of file
+
+    WakeLandings();
+    Migrate();
+    particles.RemoveParticles(leaving);
+}
+
+void ParticleWorker::BecomeCell(size_t index, SandRoom *cellRoom, sf::Vector2i p) {
+    // The cell is written straight away, so that the particles after it in the pass collide with it.
+    cellRoom->grid.Assign(
+        cellRoom->ToIndex(p), 
+        room->particles.Id(index),
+        room->particles.Colour(index));
+    landings.push_back(Landing {cellRoom, p});
+    leaving[index] = 1;
+}
+
+void ParticleWorker::WakeLandings() {
+    for (const Landing &landing : landings) {
+        landing.room->chunks.KeepContainingAlive(landing.p.x, landing.p.y);
+        landing.room->chunks.KeepNeighbourAlive(landing.p.x, landing.p.y);
+    }
+}
+
+void ParticleWorker::Migrate() {
+    if (migrations.empty()) return;
+
+    // Grouping by room keeps the order in which particles arrive the same from run to run.
+    std::stable_sort(migrations.begin(), migrations.end(), [](const Migration &a, const Migration &b) {
+        return a.room->id < b.room->id;
+    });
+    const ParticleSystem &particles {room->particles};
+    for (size_t first = 0; first < migrations.size();) {
+        SandRoom *dstRoom {migrations[first].room};
+        batch.clear();
+        size_t last {first};
+        for (; last < migrations.size() && migrations[last].room == dstRoom; ++last) {
+            batch.push_back(particles.Get(migrations[last].index));
+        }
+        dstRoom->AddParticles(batch);
+        first = last;
+    }
+}
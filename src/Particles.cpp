@@ -1,54 +1,150 @@
 #include "Constants.hpp"
 #include "Particles.hpp"
-#include "Utility/Physics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
 
-sf::Vector2i Particle::Position() const {
-    return sf::Vector2i {
-        static_cast<int>(std::roundf(p.x)),
-        static_cast<int>(std::roundf(p.y))
-    };
-}
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define PARTICLES_SSE
+#include <xmmintrin.h>
+#endif
 
-void Particle::Position(sf::Vector2i newP) {
-    p = sf::Vector2f {newP};
-}
+namespace {
 
-void Particle::ApplyForce(sf::Vector2f Fapplied) {
-    F = Fapplied;
-}
+    // The acceleration of the particles, from the applied force, the drag and gravity.
+    const float dragFactor {-constants::k / constants::M};
+    const float forceFactor {1.f / constants::M};
+    const sf::Vector2f gravity {5.f * constants::accelGravity};
+
+    void Acceleration(float vx, float vy, float Fx, float Fy, float &ax, float &ay) {
+        const float drag {dragFactor * std::sqrt(vx * vx + vy * vy)};
+        ax = Fx * forceFactor + drag * vx + gravity.x;
+        ay = Fy * forceFactor + drag * vy + gravity.y;
+    }
+
+#ifdef PARTICLES_SSE
+    // Four particles at a time.
+    void Acceleration(__m128 vx, __m128 vy, __m128 Fx, __m128 Fy, __m128 &ax, __m128 &ay) {
+        const __m128 speed {_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)))};
+        const __m128 drag  {_mm_mul_ps(_mm_set1_ps(dragFactor), speed)};
+        const __m128 force {_mm_set1_ps(forceFactor)};
+        ax = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Fx, force), _mm_mul_ps(drag, vx)), _mm_set1_ps(gravity.x));
+        ay = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Fy, force), _mm_mul_ps(drag, vy)), _mm_set1_ps(gravity.y));
+    }
+#endif
 
-void Particle::Integrate(float dt) {
-    // Calculate the drag force.
-    float vMag = std::sqrtf(v.x * v.x + v.y * v.y);
+    size_t Padded(size_t count) {
+        return (count + ParticleSystem::lanes - 1) / ParticleSystem::lanes * ParticleSystem::lanes;
+    }
 
-    sf::Vector2f Fdrag {-constants::k * vMag * v};
+}
 
-    sf::Vector2f a {((F + Fdrag) / constants::M) + 5.f * constants::accelGravity};
-    v = v + a * dt;
-    p = p + v * dt;
+void ParticleSystem::AddParticle(const Particle &particle, sf::Vector2f Finit) {
+    Reserve(numParticles + 1);
+    px[numParticles]        = particle.p.x;
+    py[numParticles]        = particle.p.y;
+    vx[numParticles]        = particle.v.x;
+    vy[numParticles]        = particle.v.y;
+    Fx[numParticles]        = Finit.x;
+    Fy[numParticles]        = Finit.y;
+    ids[numParticles]       = particle.id;
+    colours[numParticles]   = particle.colour;
 
-    ApplyForce();
+    numParticles++;
 }
 
-void ParticleSystem::AddParticle(Particle &particle, sf::Vector2f Finit) {
-    if (numParticles < particles.size()) {
-        particles[numParticles] = particle;
-    } else {
-        particles.push_back(particle);
+void ParticleSystem::AddParticles(const std::vector<Particle> &batch) {
+    Reserve(numParticles + batch.size());
+    for (const Particle &particle : batch) {
+        AddParticle(particle);
     }
-    particles[numParticles].ApplyForce(Finit);
+}
 
-    numParticles++;
+void ParticleSystem::AddParticles(const std::vector<Launch> &batch) {
+    Reserve(numParticles + batch.size());
+    for (const Launch &launch : batch) {
+        AddParticle(launch.particle, launch.F);
+    }
+}
+
+void ParticleSystem::RemoveParticles(const std::vector<uint8_t> &removed) {
+    // Slide each kept particle down over the removed ones.
+    size_t kept {0};
+    for (size_t i = 0; i < numParticles; ++i) {
+        if (removed[i]) continue;
+        if (kept != i) {
+            px[kept]        = px[i];
+            py[kept]        = py[i];
+            vx[kept]        = vx[i];
+            vy[kept]        = vy[i];
+            Fx[kept]        = Fx[i];
+            Fy[kept]        = Fy[i];
+            ids[kept]       = ids[i];
+            colours[kept]   = colours[i];
+        }
+        ++kept;
+    }
+    numParticles = kept;
 }
 
+void ParticleSystem::Integrate(float dt, Integrator integrator) {
+    const size_t count {Padded(numParticles)};
+    const float halfDt {0.5f * dt};
+    size_t i {0};
+
+#ifdef PARTICLES_SSE
+    const __m128 dt4 {_mm_set1_ps(dt)}, halfDt4 {_mm_set1_ps(halfDt)};
+    for (; i < count; i += 4) {
+        __m128 x  {_mm_loadu_ps(&px[i])}, y  {_mm_loadu_ps(&py[i])};
+        __m128 u  {_mm_loadu_ps(&vx[i])}, w  {_mm_loadu_ps(&vy[i])};
+        __m128 Fu {_mm_loadu_ps(&Fx[i])}, Fw {_mm_loadu_ps(&Fy[i])};
+        __m128 ax, ay;
+
+        Acceleration(u, w, Fu, Fw, ax, ay);
+        if (integrator == Integrator::EULER) {
+            u = _mm_add_ps(u, _mm_mul_ps(ax, dt4));
+            w = _mm_add_ps(w, _mm_mul_ps(ay, dt4));
+            x = _mm_add_ps(x, _mm_mul_ps(u, dt4));
+            y = _mm_add_ps(y, _mm_mul_ps(w, dt4));
+        } else {
+            u = _mm_add_ps(u, _mm_mul_ps(ax, halfDt4));
+            w = _mm_add_ps(w, _mm_mul_ps(ay, halfDt4));
+            x = _mm_add_ps(x, _mm_mul_ps(u, dt4));
+            y = _mm_add_ps(y, _mm_mul_ps(w, dt4));
+            Acceleration(u, w, Fu, Fw, ax, ay);
+            u = _mm_add_ps(u, _mm_mul_ps(ax, halfDt4));
+            w = _mm_add_ps(w, _mm_mul_ps(ay, halfDt4));
+        }
 
-void ParticleSystem::RemoveParticle(size_t index) {
-    numParticles--;
-    // std::swap(particles[index], particles[numParticles]); // Move the particle that is to  deleted to the end of the active list.
-    Particle tmp {particles[numParticles]};
-    particles[index] = tmp;
+        _mm_storeu_ps(&px[i], x);
+        _mm_storeu_ps(&py[i], y);
+        _mm_storeu_ps(&vx[i], u);
+        _mm_storeu_ps(&vy[i], w);
+        _mm_storeu_ps(&Fx[i], _mm_setzero_ps());
+        _mm_storeu_ps(&Fy[i], _mm_setzero_ps());
+    }
+#endif
 
-    // return particles[numParticles];
+    for (; i < count; ++i) {
+        float ax, ay;
+        Acceleration(vx[i], vy[i], Fx[i], Fy[i], ax, ay);
+        if (integrator == Integrator::EULER) {
+            vx[i] += ax * dt;
+            vy[i] += ay * dt;
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+        } else {
+            vx[i] += ax * halfDt;
+            vy[i] += ay * halfDt;
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            Acceleration(vx[i], vy[i], Fx[i], Fy[i], ax, ay);
+            vx[i] += ax * halfDt;
+            vy[i] += ay * halfDt;
+        }
+        Fx[i] = 0.f;
+        Fy[i] = 0.f;
+    }
 }
 
 size_t ParticleSystem::Range() const {
@@ -56,12 +152,36 @@ size_t ParticleSystem::Range() const {
 }
 
 size_t ParticleSystem::Capacity() const {
-    return particles.size();
+    return px.size();
+}
+
+Particle ParticleSystem::Get(size_t index) const {
+    Particle particle {ids[index], sf::Vector2i {}, colours[index]};
+    particle.p = sf::Vector2f {px[index], py[index]};
+    particle.v = sf::Vector2f {vx[index], vy[index]};
+    return particle;
 }
 
-Particle& ParticleSystem::operator[](size_t n) {
-    if (n > numParticles - 1) {
-        throw std::out_of_range("Supplied index (n) is greater than the number of active particles.");
+sf::Vector2i ParticleSystem::Position(size_t index) const {
+    return sf::Vector2i {
+        static_cast<int>(std::roundf(px[index])),
+        static_cast<int>(std::roundf(py[index]))
+    };
+}
+
+void ParticleSystem::Position(size_t index, sf::Vector2i newP) {
+    px[index] = static_cast<float>(newP.x);
+    py[index] = static_cast<float>(newP.y);
+}
+
+void ParticleSystem::Reserve(size_t count) {
+    if (count <= px.size()) return;
+
+    // The padding is integrated too. It starts at rest, and drag caps its speed from then on.
+    const size_t capacity {Padded(std::max(count, 2 * px.size()))};
+    for (std::vector<float> *component : {&px, &py, &vx, &vy, &Fx, &Fy}) {
+        component->resize(capacity, 0.f);
     }
-    return particles.at(n);
-}
\ No newline at end of file
+    ids.resize(capacity, Element::null);
+    colours.resize(capacity);
+}
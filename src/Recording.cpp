@@ -0,0 +1,136 @@
+#include "Recording.hpp"
+#include "Scenario.hpp"
+#include "Utility/Hashes.hpp"
+#include "Utility/Line.hpp"
+#include "Utility/Random.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+    // The random sequence that painting draws from. Kept apart from the sequences that rooms use for their stages.
+    constexpr uint64_t paintStream {std::numeric_limits<uint64_t>::max()};
+
+}
+
+bool Recording::Save(const std::string &path, const ElementProperties &properties) const {
+    std::ofstream file {path};
+    if (!file) {
+        std::cerr << "Failed to open recording: " << path << "\n";
+        return false;
+    }
+
+    // Enough digits for the dt to be read back exactly.
+    file << std::setprecision(std::numeric_limits<float>::max_digits10);
+    file << "seed "  << seed  << "\n";
+    file << "dt "    << dt    << "\n";
+    file << "ticks " << ticks << "\n";
+    for (const Viewpoint &view : views) {
+        file << "view " << view.tick << " " << view.centre.x << " " << view.centre.y << " " << view.size.x << " " << view.size.y << "\n";
+    }
+    for (const Stroke &stroke : strokes) {
+        file << "stroke " << stroke.tick << " " << properties.constants[stroke.brush].name << " " << stroke.radius << " "
+             << stroke.start.x << " " << stroke.start.y << " " << stroke.end.x << " " << stroke.end.y << "\n";
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool Recording::Load(const std::string &path, const ElementProperties &properties) {
+    std::ifstream file {path};
+    if (!file) {
+        std::cerr << "Failed to open recording: " << path << "\n";
+        return false;
+    }
+
+    Recording loaded;
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        std::istringstream stream {line.substr(0, line.find('#'))};
+        std::string command;
+        if (!(stream >> command)) continue; // Blank line or comment.
+
+        bool valid = false;
+        if (command == "seed") {
+            valid = static_cast<bool>(stream >> loaded.seed);
+        } else if (command == "dt") {
+            valid = stream >> loaded.dt && loaded.dt > 0.f;
+        } else if (command == "ticks") {
+            valid = static_cast<bool>(stream >> loaded.ticks);
+        } else if (command == "view") {
+            Viewpoint view;
+            if (stream >> view.tick >> view.centre.x >> view.centre.y >> view.size.x >> view.size.y) {
+                valid = view.size.x > 0 && view.size.y > 0
+                    && (loaded.views.empty() || loaded.views.back().tick <= view.tick);
+                if (valid) loaded.views.push_back(view);
+            }
+        } else if (command == "stroke") {
+            Stroke stroke;
+            std::string name;
+            if (stream >> stroke.tick >> name >> stroke.radius >> stroke.start.x >> stroke.start.y >> stroke.end.x >> stroke.end.y) {
+                stroke.brush = ElementFromName(properties, name);
+                valid = stroke.brush != Element::null && stroke.radius > 0
+                    && (loaded.strokes.empty() || loaded.strokes.back().tick <= stroke.tick);
+                if (valid) loaded.strokes.push_back(stroke);
+            }
+        }
+
+        if (!valid) {
+            std::cerr << path << ":" << lineNumber << ": invalid recording entry: " << line << "\n";
+            return false;
+        }
+    }
+
+    *this = std::move(loaded);
+    return true;
+}
+
+void Recording::RecordView(uint64_t tick, sf::Vector2i centre, sf::Vector2i size) {
+    if (!views.empty() && views.back().centre == centre && views.back().size == size) return;
+    views.push_back(Viewpoint {tick, centre, size});
+}
+
+void PaintStroke(SandWorld &world, const Stroke &stroke) {
+    SeedStream(world.Ticks(), PackPoint(stroke.start.x, stroke.start.y), paintStream);
+
+    const int radius {stroke.radius};
+    // The view spawns the rooms under strokes painted in the game, but recordings without a view don't have one.
+    const int left {std::min(stroke.start.x, stroke.end.x) - (radius - 1)}, right {std::max(stroke.start.x, stroke.end.x) + radius};
+    const int top  {std::max(stroke.start.y, stroke.end.y) + radius}, bottom {std::min(stroke.start.y, stroke.end.y) - (radius - 1)};
+    SpawnArea(world, left, bottom, right - left, top - bottom);
+
+    for (sf::Vector2i pos : Lerp {stroke.start, stroke.end}) {
+        if (radius == 1) {
+            world.SetCell(pos.x, pos.y, stroke.brush); // TODO: Cache the room that the mouse is in.
+        } else {
+            world.SetArea(pos.x - (radius - 1), pos.y - (radius - 1),
+                            2 * radius, 2 * radius, stroke.brush);
+        }
+    }
+}
+
+void Replayer::Advance(SandWorld &world) {
+    // The game follows the view every step, whether or not it moved.
+    if (const Viewpoint *current {ViewAt(world.Ticks())}) world.FollowView(current->centre, current->size);
+    PaintStrokes(world);
+}
+
+const Viewpoint *Replayer::ViewAt(uint64_t tick) {
+    const std::vector<Viewpoint> &views {recording->views};
+    for (; nextView < views.size() && views[nextView].tick <= tick; ++nextView) {
+        view = &views[nextView];
+    }
+    return view;
+}
+
+void Replayer::PaintStrokes(SandWorld &world) {
+    // Recorded strokes were painted before the step they're stamped with.
+    const std::vector<Stroke> &strokes {recording->strokes};
+    for (; nextStroke < strokes.size() && strokes[nextStroke].tick <= world.Ticks(); ++nextStroke) {
+        PaintStroke(world, strokes[nextStroke]);
+    }
+}
@@ -0,0 +1,298 @@
+#include "RoomCodec.hpp"
+#include <cstring>
+
+namespace {
+
+    // Chunk flags. The optional planes are only stored when a cell in the chunk holds something other than the default.
+    enum ChunkFlags : uint8_t {
+        HAS_VELOCITY    = 0b0001,
+        HAS_HEALTH      = 0b0010,
+        HAS_DATA        = 0b0100
+    };
+
+    // Marks a cell whose colour isn't in its element's palette. The colour itself follows the run.
+    constexpr uint8_t literalColour {0xFF};
+
+    //////// Byte streams ////////
+
+    void PutVarint(std::vector<uint8_t> &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    template <typename T>
+    void PutValue(std::vector<uint8_t> &out, T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    class Reader {
+    private:
+        const uint8_t *pos, *end;
+        bool ok {true};
+
+    public:
+        Reader(const uint8_t *data, size_t size) : pos(data), end(data + size) {}
+
+        bool Ok() const { return ok; }
+        bool AtEnd() const { return pos == end; }
+
+        uint64_t Varint() {
+            uint64_t value {0};
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos == end) break;
+                uint8_t byte {*pos++};
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+            ok = false;
+            return 0;
+        }
+
+        template <typename T>
+        T Value() {
+            T value {};
+            if (static_cast<size_t>(end - pos) < sizeof(T)) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        const uint8_t *Bytes(size_t n) {
+            if (static_cast<size_t>(end - pos) < n) {
+                ok = false;
+                return nullptr;
+            }
+            const uint8_t *bytes {pos};
+            pos += n;
+            return bytes;
+        }
+    };
+
+    uint32_t ReadU32(const uint8_t *bytes) {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    //////// Runs ////////
+
+    // Writes the values get(0), ..., get(n - 1) as runs of [length, value].
+    template <typename T, typename Getter>
+    void PutRuns(std::vector<uint8_t> &out, int n, Getter get) {
+        int k {0};
+        while (k < n) {
+            T value {get(k)};
+            int length {1};
+            while (k + length < n && get(k + length) == value) ++length;
+
+            PutVarint(out, length);
+            PutValue<T>(out, value);
+            k += length;
+        }
+    }
+
+    // Reads n values that were written by PutRuns, passing each to set(k, value).
+    template <typename T, typename Setter>
+    bool GetRuns(Reader &in, int n, Setter set) {
+        int k {0};
+        while (k < n && in.Ok()) {
+            uint64_t length {in.Varint()};
+            T value {in.Value<T>()};
+            if (!in.Ok() || length == 0 || length > static_cast<uint64_t>(n - k)) return false;
+
+            for (int end = k + static_cast<int>(length); k < end; ++k) set(k, value);
+        }
+        return in.Ok();
+    }
+
+    // Visits the cells of a chunk in row order, passing the running count and the room index of each.
+    struct ChunkCells {
+        int xMin, yMin, width, height, roomWidth;
+
+        ChunkCells(const SandRoom &room, int chunk) {
+            ChunkBounds bounds {room.chunks.GetBounds(chunk)};
+            xMin        = bounds.x - room.x;
+            yMin        = bounds.y - room.y;
+            width       = bounds.width;
+            height      = bounds.height;
+            roomWidth   = room.width;
+        }
+
+        int Size() const { return width * height; }
+        size_t Index(int k) const { return (yMin + k / width) * roomWidth + xMin + k % width; }
+    };
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Encoding.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void RoomCodec::EncodeChunk(const SandRoom &room, int chunk, std::vector<uint8_t> &out) {
+    const Cells &grid {room.grid};
+    const ElementProperties &properties {*grid.properties};
+    const ChunkCells cells {room, chunk};
+    const int n {cells.Size()};
+
+    uint8_t flags {0};
+    for (int k = 0; k < n; ++k) {
+        size_t i {cells.Index(k)};
+        if (grid.velocities[i].x || grid.velocities[i].y)               flags |= HAS_VELOCITY;
+        if (grid.healths.Get(i) != grid.healths.Fallback())             flags |= HAS_HEALTH;
+        if (grid.datas.Get(i) != grid.datas.Fallback())                 flags |= HAS_DATA;
+    }
+    out.push_back(flags);
+
+    PutRuns<uint8_t>(out, n, [&](int k) { return grid.ids[cells.Index(k)]; });
+
+    // Colours are written as palette indices, with the colours that aren't in the palette written after their run.
+    std::vector<uint8_t> codes(n);
+    for (int k = 0; k < n; ++k) {
+        size_t i {cells.Index(k)};
+        sf::Vector2i p {room.ToWorldCoords(static_cast<int>(i))};
+        int index {properties.PaletteIndex(grid.Id(i), grid.colour[i], p.x, p.y)};
+        codes[k] = index >= 0 && index < literalColour ? static_cast<uint8_t>(index) : literalColour;
+    }
+    int k {0};
+    while (k < n) {
+        const uint8_t code {codes[k]};
+        int length {1};
+        while (k + length < n && codes[k + length] == code) ++length;
+
+        PutVarint(out, length);
+        out.push_back(code);
+        if (code == literalColour) {
+            for (int j = k; j < k + length; ++j) PutValue<uint32_t>(out, grid.colour[cells.Index(j)].ToInteger());
+        }
+        k += length;
+    }
+
+    if (flags & HAS_VELOCITY) {
+        PutRuns<uint32_t>(out, n, [&](int k) {
+            const impl::PackedVelocity &v {grid.velocities[cells.Index(k)]};
+            return static_cast<uint32_t>(static_cast<uint16_t>(v.x)) | static_cast<uint32_t>(static_cast<uint16_t>(v.y)) << 16;
+        });
+    }
+    if (flags & HAS_HEALTH) {
+        PutRuns<float>(out, n, [&](int k) { return grid.healths.Get(cells.Index(k)); });
+    }
+    if (flags & HAS_DATA) {
+        PutRuns<uint64_t>(out, n, [&](int k) { return grid.datas.Get(cells.Index(k)); });
+    }
+}
+
+std::vector<uint8_t> RoomCodec::Encode(const SandRoom &room) {
+    const int numChunks {static_cast<int>(room.chunks.Size())};
+    const size_t tableSize {sizeof(uint32_t) * (1 + 2 * numChunks)};
+
+    // The table is filled in once the size of each chunk is known.
+    std::vector<uint8_t> out(tableSize);
+    std::vector<uint32_t> table;
+    table.reserve(1 + 2 * numChunks);
+    table.push_back(numChunks);
+    for (int ci = 0; ci < numChunks; ++ci) {
+        const size_t offset {out.size()};
+        EncodeChunk(room, ci, out);
+        table.push_back(static_cast<uint32_t>(offset));
+        table.push_back(static_cast<uint32_t>(out.size() - offset));
+    }
+    std::memcpy(out.data(), table.data(), tableSize);
+
+    return out;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Decoding.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool RoomCodec::DecodeChunk(SandRoom &room, int chunk, const uint8_t *data, size_t size) {
+    Cells &grid {room.grid};
+    const ElementProperties &properties {*grid.properties};
+    const ChunkCells cells {room, chunk};
+    const int n {cells.Size()};
+    Reader in {data, size};
+
+    const uint8_t flags {in.Value<uint8_t>()};
+    bool ok {in.Ok()};
+
+    ok = ok && GetRuns<uint8_t>(in, n, [&](int k, uint8_t id) {
+        grid.ids[cells.Index(k)] = id < Element::count ? id : static_cast<uint8_t>(Element::air);
+    });
+
+    int k {0};
+    while (ok && k < n) {
+        uint64_t length {in.Varint()};
+        uint8_t  code   {in.Value<uint8_t>()};
+        if (!in.Ok() || length == 0 || length > static_cast<uint64_t>(n - k)) return false;
+
+        for (int end = k + static_cast<int>(length); k < end; ++k) {
+            size_t i {cells.Index(k)};
+            if (code == literalColour) {
+                grid.colour[i] = Colour(in.Value<uint32_t>());
+            } else {
+                sf::Vector2i p {room.ToWorldCoords(static_cast<int>(i))};
+                grid.colour[i] = properties.PaletteColour(grid.Id(i), code, p.x, p.y);
+            }
+        }
+        ok = in.Ok();
+    }
+
+    if (ok && (flags & HAS_VELOCITY)) {
+        ok = GetRuns<uint32_t>(in, n, [&](int k, uint32_t v) {
+            grid.velocities[cells.Index(k)] = impl::PackedVelocity {
+                static_cast<int16_t>(v & 0xFFFF), static_cast<int16_t>(v >> 16)};
+        });
+    }
+    if (ok && (flags & HAS_HEALTH)) {
+        ok = GetRuns<float>(in, n, [&](int k, float health) {
+            if (health != grid.healths.Fallback()) grid.healths.Ref(cells.Index(k)) = health;
+        });
+    }
+    if (ok && (flags & HAS_DATA)) {
+        ok = GetRuns<uint64_t>(in, n, [&](int k, uint64_t value) {
+            if (value != grid.datas.Fallback()) grid.datas.Ref(cells.Index(k)) = value;
+        });
+    }
+
+    return ok && in.AtEnd();
+}
+
+bool RoomCodec::Decode(SandRoom &room, const uint8_t *data, size_t size) {
+    const int numChunks {static_cast<int>(room.chunks.Size())};
+    bool ok {size >= sizeof(uint32_t) * (1 + 2 * numChunks) && ReadU32(data) == static_cast<uint32_t>(numChunks)};
+
+    for (int ci = 0; ok && ci < numChunks; ++ci) {
+        const uint32_t offset   {ReadU32(data + sizeof(uint32_t) * (1 + 2 * ci))};
+        const uint32_t length   {ReadU32(data + sizeof(uint32_t) * (2 + 2 * ci))};
+        ok = offset <= size && length <= size - offset && DecodeChunk(room, ci, data + offset, length);
+    }
+
+    // Leaves the room empty rather than half decoded.
+    if (!ok) Clear(room);
+    FinishDecode(room);
+
+    return ok;
+}
+
+bool RoomCodec::Decode(SandRoom &room, const std::vector<uint8_t> &data) {
+    return Decode(room, data.data(), data.size());
+}
+
+void RoomCodec::Clear(SandRoom &room) {
+    for (int i = 0; i < room.width * room.height; ++i) {
+        sf::Vector2i p {room.ToWorldCoords(i)};
+        room.grid.Assign(i, Element::air, p.x, p.y);
+    }
+}
+
+void RoomCodec::FinishDecode(SandRoom &room) {
+    room.grid.RebuildOccupied();
+}
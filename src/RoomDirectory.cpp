@@ -0,0 +1,117 @@
+#include "RoomDirectory.hpp"
+#include "Utility/Hashes.hpp"
+#include <utility>
+
+RoomDirectory::RoomDirectory(int _xMin, int _xMax, int _yMin, int _yMax) : 
+    xMin(_xMin), yMin(_yMin), 
+    width(static_cast<int64_t>(_xMax) - _xMin <= maxDenseRooms ? _xMax - _xMin : 0),
+    height(static_cast<int64_t>(_yMax) - _yMin <= maxDenseRooms ? _yMax - _yMin : 0),
+    mask(0), count(0) {
+    const int64_t area {static_cast<int64_t>(width) * height};
+    if (area > 0 && area <= maxDenseRooms) {
+        grid = std::make_unique<std::atomic<roomID_t>[]>(area);
+        for (int64_t i = 0; i < area; ++i) {
+            grid[i].store(-1, std::memory_order_relaxed);
+        }
+    } else {
+        table.assign(minCapacity, Slot {0, -1});
+        mask = minCapacity - 1;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Lookups.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+roomID_t RoomDirectory::Find(sf::Vector2i key) const {
+    if (grid) {
+        int64_t i {GridIndex(key)};
+        return i < 0 ? -1 : grid[i].load(std::memory_order_acquire);
+    }
+
+    return table[Probe(PackPoint(key.x, key.y))].id;
+}
+
+bool RoomDirectory::Dense() const {
+    return grid != nullptr;
+}
+
+size_t RoomDirectory::Size() const {
+    return count;
+}
+
+int64_t RoomDirectory::GridIndex(sf::Vector2i key) const {
+    const int64_t x {static_cast<int64_t>(key.x) - xMin};
+    const int64_t y {static_cast<int64_t>(key.y) - yMin};
+    if (x < 0 || x >= width || y < 0 || y >= height) return -1;
+
+    return y * width + x;
+}
+
+size_t RoomDirectory::Probe(uint64_t key) const {
+    size_t i {static_cast<size_t>(MixBits(key)) & mask};
+    while (table[i].id >= 0 && table[i].key != key) {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Modifying the directory.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void RoomDirectory::Insert(sf::Vector2i key, roomID_t id) {
+    if (grid) {
+        int64_t i {GridIndex(key)};
+        if (i < 0) return;
+        if (grid[i].exchange(id, std::memory_order_release) < 0) count++;
+        return;
+    }
+
+    // Keeps the table at most half full.
+    if (2 * (count + 1) > table.size()) Grow();
+
+    Slot &slot {table[Probe(PackPoint(key.x, key.y))]};
+    if (slot.id < 0) count++;
+    slot = Slot {PackPoint(key.x, key.y), id};
+}
+
+roomID_t RoomDirectory::Erase(sf::Vector2i key) {
+    if (grid) {
+        int64_t i {GridIndex(key)};
+        if (i < 0) return -1;
+        roomID_t id {grid[i].exchange(-1, std::memory_order_release)};
+        if (id >= 0) count--;
+        return id;
+    }
+
+    size_t i {Probe(PackPoint(key.x, key.y))};
+    roomID_t id {table[i].id};
+    if (id < 0) return -1;
+
+    // Shifts the following entries of the run back, so that no probe ever stops early at the hole.
+    size_t hole {i};
+    for (size_t j = (i + 1) & mask; table[j].id >= 0; j = (j + 1) & mask) {
+        size_t home {static_cast<size_t>(MixBits(table[j].key)) & mask};
+        // Entries whose home lies cyclically in (hole, j] are still reachable and stay put.
+        bool reachable {hole <= j ? (hole < home && home <= j) : (hole < home || home <= j)};
+        if (!reachable) {
+            table[hole] = table[j];
+            hole = j;
+        }
+    }
+    table[hole].id = -1;
+    count--;
+
+    return id;
+}
+
+void RoomDirectory::Grow() {
+    std::vector<Slot> old {std::move(table)};
+    table.assign(old.size() * 2, Slot {0, -1});
+    mask = table.size() - 1;
+    for (const Slot &slot : old) {
+        if (slot.id >= 0) table[Probe(slot.key)] = slot;
+    }
+}
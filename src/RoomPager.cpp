@@ -0,0 +1,171 @@
+#include "RoomPager.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+RoomPager::RoomPager(std::string _directory) : directory(std::move(_directory)) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    io = std::thread(&RoomPager::IoLoop, this);
+}
+
+RoomPager::~RoomPager() {
+    {
+        std::lock_guard<std::mutex> lock {mutex};
+        stopping = true;
+    }
+    taskReady.notify_all();
+    io.join();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Paging.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void RoomPager::Store(sf::Vector2i key, std::vector<uint8_t> data) {
+    std::lock_guard<std::mutex> lock {mutex};
+    buffer_ptr buffer {std::make_shared<const std::vector<uint8_t>>(std::move(data))};
+    const uint64_t generation {nextGeneration++};
+    entries[key] = Entry {State::WRITING, buffer, generation};
+    Push(Task {Task::WRITE, key, generation, buffer});
+}
+
+bool RoomPager::Contains(sf::Vector2i key) const {
+    std::lock_guard<std::mutex> lock {mutex};
+    return entries.count(key) > 0;
+}
+
+void RoomPager::Prefetch(sf::Vector2i key) {
+    std::lock_guard<std::mutex> lock {mutex};
+    auto it {entries.find(key)};
+    if (it == entries.end() || it->second.state != State::STORED) return;
+
+    it->second.state = State::READING;
+    Push(Task {Task::READ, key, it->second.generation, nullptr});
+    prefetched.push_back(key);
+    TrimPrefetched();
+}
+
+RoomPager::buffer_ptr RoomPager::Load(sf::Vector2i key) {
+    std::unique_lock<std::mutex> lock {mutex};
+    auto it {entries.find(key)};
+    if (it == entries.end()) return nullptr;
+
+    if (it->second.state == State::STORED) {
+        it->second.state = State::READING;
+        Push(Task {Task::READ, key, it->second.generation, nullptr});
+    }
+    const uint64_t generation {it->second.generation};
+    taskDone.wait(lock, [this, key, generation] {
+        auto it {entries.find(key)};
+        return it == entries.end() || it->second.generation != generation 
+            || (it->second.state != State::READING && it->second.state != State::STORED);
+    });
+
+    it = entries.find(key);
+    if (it == entries.end() || it->second.generation != generation) return nullptr;
+    return it->second.data;
+}
+
+void RoomPager::Forget(sf::Vector2i key) {
+    std::lock_guard<std::mutex> lock {mutex};
+    auto it {entries.find(key)};
+    if (it == entries.end()) return;
+
+    Push(Task {Task::REMOVE, key, it->second.generation, nullptr});
+    entries.erase(it);
+}
+
+size_t RoomPager::Size() const {
+    std::lock_guard<std::mutex> lock {mutex};
+    return entries.size();
+}
+
+std::vector<sf::Vector2i> RoomPager::Keys() const {
+    std::lock_guard<std::mutex> lock {mutex};
+    std::vector<sf::Vector2i> keys;
+    keys.reserve(entries.size());
+    for (const auto &entry : entries) {
+        keys.push_back(entry.first);
+    }
+
+    return keys;
+}
+
+void RoomPager::Push(Task task) {
+    tasks.push_back(std::move(task));
+    taskReady.notify_one();
+}
+
+void RoomPager::TrimPrefetched() {
+    while (prefetched.size() > maxPrefetched) {
+        auto it {entries.find(prefetched.front())};
+        prefetched.pop_front();
+        if (it != entries.end() && it->second.state == State::READY) {
+            it->second.state = State::STORED;
+            it->second.data.reset();
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  I/O thread.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void RoomPager::IoLoop() {
+    std::unique_lock<std::mutex> lock {mutex};
+    while (true) {
+        taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+        // Pending writes are still finished when stopping, so that nothing that was paged out is lost.
+        if (tasks.empty()) return;
+
+        Task task {std::move(tasks.front())};
+        tasks.pop_front();
+        const std::string path {Path(task.key)};
+        lock.unlock();
+
+        bool success {true};
+        std::shared_ptr<std::vector<uint8_t>> read;
+        switch (task.type) {
+            case Task::WRITE: {
+                std::ofstream file {path, std::ios::binary | std::ios::trunc};
+                file.write(reinterpret_cast<const char*>(task.data->data()), task.data->size());
+                success = static_cast<bool>(file);
+                break;
+            }
+            case Task::READ: {
+                std::ifstream file {path, std::ios::binary | std::ios::ate};
+                read = std::make_shared<std::vector<uint8_t>>(file ? static_cast<size_t>(file.tellg()) : 0);
+                file.seekg(0);
+                file.read(reinterpret_cast<char*>(read->data()), read->size());
+                success = static_cast<bool>(file);
+                break;
+            }
+            case Task::REMOVE:
+                std::remove(path.c_str());
+                break;
+        }
+
+        lock.lock();
+        auto it {entries.find(task.key)};
+        if (it == entries.end() || it->second.generation != task.generation) continue;
+
+        Entry &entry {it->second};
+        if (task.type == Task::WRITE && entry.state == State::WRITING) {
+            // Keeps the data in memory if the file couldn't be written, as it would be lost otherwise.
+            if (success) {
+                entry.state = State::STORED;
+                entry.data.reset();
+            }
+        } else if (task.type == Task::READ && entry.state == State::READING) {
+            entry.state = success ? State::READY : State::FAILED;
+            entry.data  = success ? std::move(read) : nullptr;
+            taskDone.notify_all();
+        }
+    }
+}
+
+std::string RoomPager::Path(sf::Vector2i key) const {
+    return directory + "/room_" + std::to_string(key.x) + "_" + std::to_string(key.y) + ".bin";
+}
@@ -1,8 +1,11 @@
-#include "SandWorker.hpp"
 #include "SandGame.hpp"
-#include "Utility/Line.hpp"
+#include "Utility/Random.hpp"
+#include "Utility/Stats.hpp"
+#include "Utility/Timing.hpp"
 #include <SFML/Graphics.hpp>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <utility>
 #include <vector>
@@ -32,14 +35,18 @@ void Mouse::Reset() {
 //  Game.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-SandGame::SandGame() : xMinRooms(-2), xMaxRooms(2), 
-                       yMinRooms(-1), yMaxRooms(2), 
-                       world(-2, 2, -1, 2), 
+SandGame::SandGame(int numThreads, const std::string &pageDirectory, Integrator integrator) : xMinRooms(constants::xMinRooms), xMaxRooms(constants::xMaxRooms), 
+                       yMinRooms(constants::yMinRooms), yMaxRooms(constants::yMaxRooms), 
+                       world(constants::xMinRooms, constants::xMaxRooms, constants::yMinRooms, constants::yMaxRooms), 
                        screen{constants::screenWidth, constants::screenHeight, 
-                                constants::viewWidth, constants::viewHeight, "Falling Sand"} {
-    gridImage.create(constants::roomWidth, constants::roomHeight);
-    gridTexture.create(constants::roomWidth, constants::roomHeight);
+                                constants::viewWidth, constants::viewHeight, "Falling Sand"},
+                       canvas(constants::viewWidth, constants::viewHeight), compositor(canvas) {
+    world.SetThreads(numThreads);
+    world.SetIntegrator(integrator);
+    if (!pageDirectory.empty()) world.EnablePaging(pageDirectory);
+    gridTexture.create(constants::viewWidth, constants::viewHeight);
     gridTexture.setSmooth(false);
+    gridSprite.setTexture(gridTexture);
 
     const int viewHeight {constants::viewHeight};
     screen.SetTransform(
@@ -55,6 +62,10 @@ SandGame::SandGame() : xMinRooms(-2), xMaxRooms(2),
     text.setFont(font);
     text.setFillColor(sf::Color::White);
     text.setScale(sf::Vector2f {0.45f, 0.45f});
+    stageText.setFont(font);
+    stageText.setFillColor(sf::Color::White);
+    stageText.setScale(sf::Vector2f {0.35f, 0.35f});
+    stageText.setPosition(text.getPosition() + sf::Vector2f {0.f, 16.f});
 }
 
 void SandGame::Run() {
@@ -67,6 +78,7 @@ void SandGame::Run() {
     int     fpsElapsed = 0;     // Time elapsed since the last FPS message [milliseconds].
     float paintElapsed = 0.f;   // Time elapsed since the last painting action [seconds].
     float frameElapsed = 0.f;   // Time elapsed since the last frame was drawn (not simulated) [seconds].
+    ResetFrameTimes();
     while (screen.isOpen()) {
         // Update timers.
         sf::Time dt {clock.restart()};
@@ -84,31 +96,75 @@ void SandGame::Run() {
             if (event.type == sf::Event::KeyPressed && event.key.scancode == sf::Keyboard::Scan::D) {
                 DEBUG = !DEBUG;
             }
+            if (event.type == sf::Event::KeyPressed && event.key.scancode == sf::Keyboard::Scan::T && !Tracing()) {
+                StartTrace(traceFrames, tracePath);
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.scancode == sf::Keyboard::Scan::H) {
+                heatmap = static_cast<Heatmap>((static_cast<int>(heatmap) + 1) % static_cast<int>(Heatmap::count));
+                if (heatmap != Heatmap::NONE && !world.TelemetryWindow()) world.EnableTelemetry(defaultTelemetryWindow);
+            }
+
+            // Quick save and load. Loading is disabled during sessions, as it would change the recorded workload.
+            if (event.type == sf::Event::KeyPressed && event.key.scancode == sf::Keyboard::Scan::F5) {
+                world.SaveSnapshot(quicksavePath);
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.scancode == sf::Keyboard::Scan::F9
+                && sessionMode == SessionMode::NONE) {
+                if (world.LoadSnapshot(quicksavePath)) canvas.MarkAll();
+            }
 
             SetMouseState(mouse, event, sf::Mouse::getPosition(screen));
         }
 
         if (mouse.state) {
             mouse.pos = sf::Mouse::getPosition(screen);
-            if (mouse.state == MouseState::DRAWING) {
+            if (mouse.state == MouseState::DRAWING && sessionMode != SessionMode::REPLAYING) {
                 if (paintElapsed >= mouse.brushInfo.timeout) {
                     Paint(mouse);
                     paintElapsed =  0.f;
                 }
-            } else if (mouse.state == MouseState::DRAGGING) {
+            } else if (mouse.state == MouseState::DRAGGING && sessionMode != SessionMode::REPLAYING) {
                 // The view's position DOESN'T use the transformed world coordinates, so we need to use mapPixelToCoords.
                 RepositionView(mouse);
-                text.setPosition(screen.ViewCentre() - sf::Vector2f {256.f, 128.f});
+                PlaceText();
             }
             mouse.prevPos = mouse.pos;
         }
-        UpdateVisibleRooms();
-        Step(dt.asSeconds());
+        {
+            StageTimer timer {Stage::VISIBLE_ROOMS};
+            TraceScope trace {"visible rooms"};
+            UpdateVisibleRooms();
+        }
+        // Strokes are painted once the view has spawned its rooms, which is the order that replays use.
+        for (const Stroke &stroke : pendingStrokes) {
+            Paint(stroke);
+        }
+        pendingStrokes.clear();
+        if (sessionMode == SessionMode::REPLAYING) {
+            if (world.Ticks() >= session.ticks) {
+                Close();
+                break;
+            }
+            replayer.PaintStrokes(world);
+            sf::Clock stepClock;
+            Step(session.dt);
+            stepTimes.push_back(stepClock.getElapsedTime().asMicroseconds() / 1e3f);
+        } else if (sessionMode == SessionMode::RECORDING) {
+            Step(session.dt);
+        } else {
+            Step(std::min(dt.asSeconds(), 1 / 60.f)); // DEBUG: Possibly remove this limit.
+        }
 
         if (frameElapsed > 1.f / fpsTarget) {
+            StageTimer timer {Stage::DRAW};
+            TraceScope trace {"draw"};
             Draw(screen);
-            // DEBUG ONLY - Draw the active chunks.
-            if (DEBUG) { DrawChunks(); }
+            if (heatmap != Heatmap::NONE) { DrawHeatmap(); }
+            // DEBUG ONLY - Draw the active chunks and the stage times.
+            if (DEBUG) {
+                DrawChunks();
+                screen.draw(stageText);
+            }
             screen.draw(text);
             screen.display();
             frameElapsed = 0.f;
@@ -117,19 +173,59 @@ void SandGame::Run() {
         if (fpsElapsed >= 100) {
             sprintf(fpsBuffer, "%6d", static_cast<int>(1.f / dt.asSeconds()));
             text.setString(std::string(fpsBuffer));
+            if (DEBUG) UpdateStageText();
             fpsElapsed = 0;
         } else {
             fpsElapsed += dt.asMilliseconds();
         }
+        EndFrame();
+        EndTraceFrame();
     }
 }
 
-void SandGame::Step(float dt) {
-    if (dt > 1 / 60.f) dt = 1 / 60.f; // DEBUG: Possibly remove this.
-    for (roomID_t id = 0; id < world.rooms.Range(); ++id) {
-        SandWorker worker {id, world, &world.GetRoom(id), dt};
-        worker.Step();
+void SandGame::Close() {
+    if (sessionMode == SessionMode::RECORDING) {
+        session.ticks = world.Ticks();
+        if (session.Save(recordPath, world.properties)) {
+            std::cout << "Recorded " << session.strokes.size() << " strokes over " << session.ticks << " ticks to " << recordPath << "\n";
+        }
+    } else if (sessionMode == SessionMode::REPLAYING) {
+        const Summary summary {Summarise(stepTimes)};
+        std::printf("replayed ticks:     %zu\n", summary.count);
+        std::printf("step mean:          %.3f ms\n", summary.mean);
+        std::printf("step p50/p95/p99:   %.3f / %.3f / %.3f ms\n", summary.p50, summary.p95, summary.p99);
+        std::printf("step max:           %.3f ms\n", summary.max);
+    }
+    if (world.TelemetryWindow()) world.ReportRestlessChunks(std::cout);
+    if (!frameTimesPath.empty() && ExportFrameTimes(frameTimesPath)) {
+        std::cout << "Wrote frame times to " << frameTimesPath << "\n";
     }
+    frameTimesPath.clear();
+    sessionMode = SessionMode::NONE;
+    screen.close();
+}
+
+void SandGame::Record(const std::string &path) {
+    session      = Recording {};
+    session.seed = RngSeed();
+    recordPath   = path;
+    sessionMode  = SessionMode::RECORDING;
+}
+
+bool SandGame::Replay(const std::string &path) {
+    if (!session.Load(path, world.properties)) return false;
+
+    InitRng(session.seed);
+    replayer    = Replayer {session};
+    stepTimes.clear();
+    stepTimes.reserve(session.ticks);
+    sessionMode = SessionMode::REPLAYING;
+    return true;
+}
+
+void SandGame::Step(float dt) {
+    world.Step(dt);
+    MarkChangedCells();
 }
 
 ///////////////////////////// Game interaction functions /////////////////////////////
@@ -167,19 +263,12 @@ void SandGame::Paint(Mouse &mouse) {
     sf::Vector2i end    {sf::Vector2i{screen.ToWorld(mouse.pos    )}};
     sf::Vector2i start  {sf::Vector2i{screen.ToWorld(mouse.prevPos)}};
 
-    Lerp lerp {start, end};
-    Paint(lerp, mouse.brush, std::min(mouse.radius, mouse.brushInfo.maxRadius));
+    pendingStrokes.push_back(Stroke {world.Ticks(), mouse.brush, std::min(mouse.radius, mouse.brushInfo.maxRadius), start, end});
 }
 
-void SandGame::Paint(Lerp &stroke, Element type, int radius) {
-    for (sf::Vector2i pos : stroke) {
-        if (radius == 1) {
-            world.SetCell(pos.x, pos.y, type); // TODO: Cache the room that the mouse is in.
-        } else {
-            world.SetArea(pos.x - (radius - 1), pos.y - (radius - 1),
-                            2 * radius, 2 * radius, type);
-        }
-    }
+void SandGame::Paint(const Stroke &stroke) {
+    PaintStroke(world, stroke);
+    if (sessionMode == SessionMode::RECORDING) session.strokes.push_back(stroke);
 }
 
 void SandGame::RepositionView(Mouse mouse) {
@@ -200,15 +289,52 @@ void SandGame::RepositionView(Mouse mouse) {
     screen.RepositionView(delta);
 }
 
+void SandGame::PlaceText() {
+    text.setPosition(screen.ViewCentre() - sf::Vector2f {256.f, 128.f});
+    stageText.setPosition(text.getPosition() + sf::Vector2f {0.f, 16.f});
+}
+
 ///////////////////////////// Draw functions /////////////////////////////
 
+void SandGame::MarkChangedCells() {
+    const sf::Vector2i corner {visibleRooms[0].first}; // For translating world coords to canvas coords.
+
+    std::vector<roomID_t> completed;
+    completed.reserve(4);
+    for (const std::pair<sf::Vector2i, roomID_t> &visible : visibleRooms) {
+        if (!VALID_ROOM(visible.second) || std::find(completed.begin(), completed.end(), visible.second) != completed.end())
+            continue;
+
+        SandRoom &room {world.GetRoom(visible.second)};
+        for (int ci = 0; ci < static_cast<int>(room.chunks.Size()); ++ci) {
+            ChunkBounds changed {room.chunks.GetChunk(ci).Changed()};
+            canvas.MarkDirty(changed.x - corner.x,                 changed.y - corner.y, 
+                             changed.x + changed.width - corner.x, changed.y + changed.height - corner.y);
+        }
+        completed.push_back(visible.second);
+    }
+}
+
 void SandGame::Draw(Screen &screen) {
     screen.clear();
     gridSprite.setPosition(visibleRooms[0].first.x, visibleRooms[0].first.y); // Update the sprite to sit under the view.
 
+    // Everything needs to be redrawn when the view has moved.
+    if (visibleRooms != drawnRooms) {
+        canvas.MarkAll();
+        drawnRooms = visibleRooms;
+    }
+
+    compositor.Compose(world.Jobs(), VisibleRegions(), visibleRooms[0].first);
+    canvas.Upload(gridTexture);
+    screen.Draw(gridSprite);
+}
+
+std::vector<RoomRegion> SandGame::VisibleRegions() {
     int xMin, xMax, // Determines the potion of a room that's drawn.
         yMin, yMax;
-    
+
+    std::vector<RoomRegion> regions;
     std::vector<roomID_t> completed;
     completed.reserve(4);
     for (int i = 0; i < visibleRooms.size(); ++i) {
@@ -238,54 +364,31 @@ void SandGame::Draw(Screen &screen) {
                 yMin = room.y;      yMax = intersect.y;
                 break;
         }
-        
-        // Update pixels for the visible portion of the room.
-        int blX = visibleRooms[0].first.x, blY = visibleRooms[0].first.y; // For translating world coords to view coords.
-        for (int y = yMin; y < yMax; ++y) {
-        for (int x = xMin; x < xMax; ++x) {
-            gridImage.setPixel(x - blX, y - blY, room.grid.colour[room.ToIndex(x, y)]);
-        }
-        }
-        // Draw the particles.
-        for (int ip = 0; ip < room.particles.Range(); ip++) {
-            Particle& particle {room.particles[ip]};
-            sf::Vector2i position {particle.Position()};
-            // Only draw particles that are inside the view.
-            if (position.x >= xMin && position.x < xMax && position.y >= yMin && position.y < yMax)
-                gridImage.setPixel(position.x - blX, position.y - blY, particle.colour);
-        }
+
+        regions.push_back(RoomRegion {&room, xMin, xMax, yMin, yMax});
         completed.push_back(visibleRooms[i].second);
     }
-    gridTexture.loadFromImage(gridImage);
-    gridSprite.setTexture(gridTexture);
-    screen.Draw(gridSprite);
+
+    return regions;
 }
 
 void SandGame::UpdateVisibleRooms() {
-    const sf::IntRect dimensions {screen.ViewDimensions()};
-    sf::Vector2i size {dimensions.getSize() - sf::Vector2i(1, 1)};
-
-    // Get the position of each view corner in world space.
-    sf::Vector2i corners[4] {
-        dimensions.getPosition() - sf::Vector2( size.x,  size.y) / 2,   // Bottom Left
-        dimensions.getPosition() - sf::Vector2(-size.x,  size.y) / 2,   // Bottom Right
-        dimensions.getPosition() - sf::Vector2( size.x, -size.y) / 2,   // Top Left
-        dimensions.getPosition() - sf::Vector2(-size.x, -size.y) / 2    // Top Right
-    };
-
-    std::vector<std::pair<sf::Vector2i, roomID_t>> rooms;
-    rooms.reserve(4);
-    // Make a vector that pairs each corner position with the ID of the room that contains it.
-    for (sf::Vector2i corner : corners) {
-        roomID_t roomID {world.ContainingRoomID(corner)};
-        if (!VALID_ROOM(roomID)) {
-            roomID = world.SpawnRoom(corner.x, corner.y);
+    // Replays follow the recorded view rather than the mouse.
+    if (sessionMode == SessionMode::REPLAYING) {
+        if (const Viewpoint *view {replayer.ViewAt(world.Ticks())}) {
+            screen.CentreView(sf::Vector2f(view->centre));
+            PlaceText();
         }
-        rooms.push_back(std::make_pair(corner, roomID));
+    }
+
+    const sf::IntRect dimensions {screen.ViewDimensions()};
+    // The view decides which rooms exist, so sessions keep it to give replays the same rooms.
+    if (sessionMode == SessionMode::RECORDING) {
+        session.RecordView(world.Ticks(), dimensions.getPosition(), dimensions.getSize());
     }
 
     // Update the member vector.
-    std::swap(visibleRooms, rooms);
+    visibleRooms = world.FollowView(dimensions.getPosition(), dimensions.getSize());
 }
 
 void SandGame::DrawChunks() {
@@ -293,6 +396,7 @@ void SandGame::DrawChunks() {
     rectangle.setOutlineThickness(1);
     rectangle.setFillColor(sf::Color::Transparent);
     for (roomID_t id = 0; id < world.rooms.Range(); ++id) {
+        if (!world.rooms[id]) continue; // The room has been removed.
         SandRoom &room {world.GetRoom(id)};
         rectangle.setSize(sf::Vector2f(room.width, room.height));
         rectangle.setOutlineColor(sf::Color::Red);
@@ -314,3 +418,53 @@ void SandGame::DrawChunks() {
         }
     }
 }
+
+void SandGame::DrawHeatmap() {
+    // Counts are shown on a log scale, from blue for a few up to red for every cell of the chunk.
+    const float cellsPerChunk {static_cast<float>(constants::chunkWidth * constants::chunkHeight)};
+    const float scale {std::log1p(heatmap == Heatmap::AWAKE ? static_cast<float>(world.TelemetryWindow()) : cellsPerChunk)};
+
+    sf::RectangleShape rectangle;
+    for (roomID_t id = 0; id < world.rooms.Range(); ++id) {
+        if (!world.rooms[id]) continue; // The room has been removed.
+        SandRoom &room {world.GetRoom(id)};
+        for (int i = 0; i < static_cast<int>(room.chunks.Size()); i++) {
+            const ChunkActivity &activity {room.chunks.GetChunk(i).activity};
+            uint32_t count {0};
+            switch (heatmap) {
+                case Heatmap::VISITED:  count = activity.visited;   break;
+                case Heatmap::UPDATED:  count = activity.updated;   break;
+                case Heatmap::MOVES:    count = activity.moves;     break;
+                case Heatmap::LOST:     count = activity.lost;      break;
+                case Heatmap::ACTIONS:  count = activity.actions;   break;
+                case Heatmap::AWAKE:    count = activity.awakeFor;  break;
+                default:                                            break;
+            }
+            if (count == 0) continue;
+
+            const float t {std::min(std::log1p(static_cast<float>(count)) / scale, 1.f)};
+            const ChunkBounds bounds {room.chunks.GetBounds(i)};
+            rectangle.setSize(sf::Vector2f(bounds.width, bounds.height));
+            rectangle.setPosition(bounds.x, bounds.y);
+            rectangle.setFillColor(sf::Color(static_cast<sf::Uint8>(255 * t), 0, static_cast<sf::Uint8>(255 * (1.f - t)),
+                                             static_cast<sf::Uint8>(48 + 128 * t)));
+            screen.Draw(rectangle);
+        }
+    }
+}
+
+void SandGame::UpdateStageText() {
+    char line[64];
+    std::string table {"stage           avg    p50    p95    p99 [ms]\n"};
+    for (int i = 0; i < static_cast<int>(Stage::count); ++i) {
+        const Summary summary {RecentStageTimes(static_cast<Stage>(i))};
+        std::snprintf(line, sizeof(line), "%-13s %6.2f %6.2f %6.2f %6.2f\n",
+                      StageName(static_cast<Stage>(i)), summary.mean, summary.p50, summary.p95, summary.p99);
+        table += line;
+    }
+    const Summary frame {RecentFrameTimes()};
+    std::snprintf(line, sizeof(line), "%-13s %6.2f %6.2f %6.2f %6.2f\n", "frame", frame.mean, frame.p50, frame.p95, frame.p99);
+    table += line;
+
+    stageText.setString(table);
+}
@@ -9,31 +9,67 @@
 //////////////////////////////////////////////////////////////////////////////////////////
 
 SandRoom::SandRoom(int _x, int _y, int _width, int _height, const ElementProperties * properties) : 
-    x(_x), y(_y), width(_width), height(_height), 
+    id(-1), x(_x), y(_y), width(_width), height(_height), 
     grid(_width, _height, properties),
-    chunks(constants::numXChunks, constants::numYChunks, constants::chunkWidth, constants::chunkHeight, x, y) {}
+    chunks(constants::numXChunks, constants::numYChunks, constants::chunkWidth, constants::chunkHeight, x, y),
+    scheduled(false) {
+    chunks.SetWakeHandler([this] { Schedule(); });
+    for (std::atomic<SandRoom*> &neighbour : neighbours) {
+        neighbour.store(nullptr, std::memory_order_relaxed);
+    }
+    neighbours[NeighbourSlot(0, 0)].store(this, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Scheduling.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SandRoom::SetScheduleHandler(std::function<void()> handler) {
+    onSchedule = std::move(handler);
+}
+
+void SandRoom::Schedule() {
+    if (!onSchedule || scheduled.load(std::memory_order_relaxed)) return;
+    if (!scheduled.exchange(true, std::memory_order_relaxed)) onSchedule();
+}
+
+void SandRoom::Unschedule() {
+    scheduled.store(false, std::memory_order_relaxed);
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //  Access Functions.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-void SandRoom::QueueMovement(roomID_t srcRoomID, int pFrom, int pTo) {
-    queuedMoves.emplace_back(srcRoomID, pFrom, pTo);
+static_assert(constants::roomWidth * constants::roomHeight <= (1 << Move::indexBits), "Cell indices must fit in a Move.");
+static_assert(Element::count <= (1 << (32 - Move::indexBits)), "Elements must fit in an Action.");
+
+void SandRoom::Enqueue(const std::vector<Move> &moves, const std::vector<Action> &actions) {
+    queuedMoves.insert(queuedMoves.end(), moves.begin(), moves.end());
+    queuedActions.insert(queuedActions.end(), actions.begin(), actions.end());
+}
+
+void SandRoom::AddParticles(const std::vector<Particle> &batch) {
+    std::lock_guard<std::mutex> lock {particlesMutex};
+    particles.AddParticles(batch);
+    Schedule();
 }
 
-void SandRoom::QueueAction(size_t i, Element transform) {
-    queuedActions.emplace_back(i, transform);
+void SandRoom::AddParticles(const std::vector<Launch> &batch) {
+    std::lock_guard<std::mutex> lock {particlesMutex};
+    particles.AddParticles(batch);
+    Schedule();
 }
 
-CellState& SandRoom::GetCell(int index) {
-    return grid.state.at(index);
+CellState SandRoom::GetCell(int index) {
+    return grid.At(index);
 }
 
-CellState& SandRoom::GetCell(int _x, int _y) {
+CellState SandRoom::GetCell(int _x, int _y) {
     return GetCell(ToIndex(_x, _y));
 }
 
-CellState& SandRoom::GetCell(sf::Vector2i p) {
+CellState SandRoom::GetCell(sf::Vector2i p) {
     return GetCell(ToIndex(p.x, p.y));
 }
 
@@ -58,7 +94,7 @@ void SandRoom::SetCell(int _x, int _y, Element id) {
 
 bool SandRoom::IsEmpty(int _x, int _y) {
     if (InBounds(_x, _y)) {
-        return GetCell(ToIndex(_x, _y)).id == Element::air;
+        return grid.Id(ToIndex(_x, _y)) == Element::air;
     } else {
         return false;   
     }
@@ -77,6 +113,21 @@ bool SandRoom::InBounds(sf::Vector2i p) const {
     return InBounds(p.x, p.y);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Neighbouring rooms.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool SandRoom::Adjacent(sf::Vector2i p) const {
+    return p.x >= x - width  && p.x < x + 2 * width 
+        && p.y >= y - height && p.y < y + 2 * height;
+}
+
+SandRoom *SandRoom::NeighbourContaining(sf::Vector2i p) const {
+    const int dx {(p.x >= x + width)  - (p.x < x)};
+    const int dy {(p.y >= y + height) - (p.y < y)};
+    return Neighbour(NeighbourSlot(dx, dy));
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //  Helper functions.
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -1,55 +1,252 @@
 #include "Constants.hpp"
 #include "SandWorker.hpp"
+#include "Utility/Bits.hpp"
+#include "Utility/Hashes.hpp"
+#include "Utility/Random.hpp"
+#include "Utility/Timing.hpp"
+#include "Utility/Trace.hpp"
+#include <algorithm>
+#include <vector>
 
-SandWorker::SandWorker(roomID_t id, SandWorld &_world, SandRoom *_room, float _dt) :
-    movement(id, _world, _room, _dt), actions(id, _world, _room, particles, _dt), particles(id, _world, _room, _dt),
-    room(_room), properties(_world.properties) {}
+namespace {
+
+    // The random sequence of each stage. Chunks use their index, so these start past the last chunk.
+    enum Stream : uint64_t {
+        PARTICLES   = 64,
+        CONSOLIDATE,
+        FINISH,
+        BLAST
+    };
+
+}
+
+SandWorker::SandWorker(roomID_t id, SandWorld &_world, SandRoom *_room) :
+    room(_room), world(_world), properties(_world.properties), 
+    resolver(static_cast<size_t>(_room->width) * _room->height),
+    outboxes(_room->chunks.Size()),
+    particles(id, _world, _room), movement(id, _world, _room), actions(id, _world, _room, particles) {}
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //  Simulation.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-void SandWorker::Step() {
-    particles.ProcessParticles();
-    for (int ci = 0; ci < room->chunks.Size(); ++ci) {
-        Chunk &chunk {room->chunks.GetChunk(ci)};
-        room->chunks.UpdateChunk(ci);
+void SandWorker::BeginStep(float dt) {
+    TraceScope trace {"begin step", "room", room->id};
+    particles.SetDt(dt);
+    movement.SetDt(dt);
+    actions.SetDt(dt);
+    actions.ReserveScratch(world.Jobs().Size());
+
+    SeedStream(Stream::PARTICLES);
+    {
+        StageTimer timer {Stage::PARTICLES};
+        TraceScope particlesTrace {"particles", "room", room->id};
+        particles.ProcessParticles();
+    }
+
+    // All chunks are updated up front, so a chunk that is woken up by one of its neighbours 
+    // is simulated next frame regardless of which phase the neighbour ran in.
+    for (std::vector<int> &phase : phases) {
+        phase.clear();
+    }
+    const uint64_t awake {room->chunks.Update()};
+    for (uint64_t bits {awake}; bits; bits &= bits - 1) {
+        const int ci {LowestBit(bits)};
+        phases[room->chunks.Phase(ci)].push_back(ci);
+    }
+
+    if (const int window {world.TelemetryWindow()}) UpdateActivity(awake, window);
+}
+
+const std::vector<int> &SandWorker::ActiveChunks(int phase) const {
+    return phases[phase];
+}
+
+size_t SandWorker::SimulateChunk(int index) {
+    TraceScope trace {"chunk", "room", room->id, "chunk", index};
+    SeedStream(index);
+    InteractionWorker::SetOutbox(&outboxes[index]);
+    Chunk &chunk {room->chunks.GetChunk(index)};
+    ChunkActivity *activity {world.TelemetryWindow() ? &chunk.activity : nullptr};
+    size_t updated {SimulateChunkCells(chunk, activity)};
+    InteractionWorker::SetOutbox(nullptr);
+
+    if (activity) {
+        activity->updated = static_cast<uint32_t>(updated);
+        for (const std::vector<Move> &moves : outboxes[index].moves) {
+            activity->moves += static_cast<uint32_t>(moves.size());
+        }
+    }
+
+    return updated;
+}
+
+void SandWorker::TakeDetonations(std::vector<sf::Vector2i> &detonations) {
+    actions.TakeDetonations(detonations);
+}
+
+void SandWorker::ResolveBlast(const Blast &blast) {
+    TraceScope trace {"blast", "room", room->id, "detonations", static_cast<int64_t>(blast.detonations)};
+    // Blasts are keyed by their origin, as a room may resolve several in a step.
+    ::SeedStream(world.Ticks(), PackPoint(blast.origin.x, blast.origin.y), Stream::BLAST);
+    const sf::Vector2i chunk {room->chunks.ContainingChunk(blast.origin.x, blast.origin.y)};
+    InteractionWorker::SetOutbox(&outboxes[chunk.x + chunk.y * constants::numXChunks]);
+    actions.Explode(blast);
+    InteractionWorker::SetOutbox(nullptr);
+}
+
+std::vector<Outbox> &SandWorker::Outboxes() {
+    return outboxes;
+}
 
-        SimulateChunk(chunk);
+void SandWorker::Consolidate() {
+    TraceScope trace {"consolidate", "room", room->id};
+    SeedStream(Stream::CONSOLIDATE);
+    if (world.TelemetryWindow()) {
+        for (int ci = 0; ci < static_cast<int>(room->chunks.Size()); ++ci) {
+            room->chunks.GetChunk(ci).activity.ResetConsolidation();
+        }
+    }
+    {
+        StageTimer timer {Stage::CONSOLIDATE_ACTIONS};
+        actions.ConsolidateActions(resolver);
+    }
+    {
+        StageTimer timer {Stage::CONSOLIDATE_MOVEMENT};
+        movement.ConsolidateMovement(resolver);
     }
+}
+
+void SandWorker::FinishStep() {
+    TraceScope trace {"finish step", "room", room->id};
+    SeedStream(Stream::FINISH);
+    StageTimer timer {Stage::FINISH};
+    movement.ApplyDeferredMoves();
+}
 
-    actions.ConsolidateActions();
-    movement.ConsolidateMovement();
+void SandWorker::SeedStream(uint64_t stream) const {
+    // Rooms are keyed by position rather than ID, as IDs depend on the order in which rooms were spawned.
+    ::SeedStream(world.Ticks(), PackPoint(room->x, room->y), stream);
 }
 
-void SandWorker::SimulateChunk(Chunk &chunk) {
-    for (int y = chunk.yMin; y < chunk.yMax; ++y) { // Inactive chunks will have yMin > yMax.
-        // Process each row.
+size_t SandWorker::SimulateChunkCells(Chunk &chunk, ChunkActivity *activity) {
+    if (chunk.xMin >= chunk.xMax) return 0; // Inactive chunks will have xMin > xMax.
+
+    // Only the occupied cells of the dirty rect are visited, by walking the set bits of the room's occupancy rows.
+    // Cells don't change until the queued moves and actions are consolidated, so the rows can be read as we go.
+    const int xBegin    {chunk.xMin - room->x};
+    const int xEnd      {chunk.xMax - room->x};
+    const int wordBegin {xBegin / 64};
+    const int wordEnd   {(xEnd - 1) / 64 + 1};
+
+    size_t updated {0};
+    for (int y = chunk.yMin; y < chunk.yMax; ++y) {
+        const int row {y - room->y};
+
         // Alternate processing rows left to right and right to left.
-        int dir = std::abs(y % 2);
-        int endpoints[] {chunk.xMin, chunk.xMax - 1};
-        int start   = endpoints[1 - dir];
-        int end     = endpoints[dir];
-        dir = 2 * dir - 1;
-        end += dir;
-        for (int x = start; x != end; x += dir) {
-            // Apply the simulation.
-            if (ApplyRules(sf::Vector2i(x, y))) {
-                movement.KeepContainingAlive(x, y);
-                movement.KeepNeighbourAlive(x, y);
+        if (std::abs(y % 2) == 1) {
+            for (int word = wordBegin; word < wordEnd; ++word) {
+                uint64_t bits {room->grid.OccupiedWord(row, word) & WordMask(word, xBegin, xEnd)};
+                if (activity) activity->visited += PopCount(bits);
+                while (bits) {
+                    int bit {LowestBit(bits)};
+                    bits &= bits - 1;
+                    updated += SimulateCell(room->x + word * 64 + bit, y, activity);
+                }
+            }
+        } else {
+            for (int word = wordEnd - 1; word >= wordBegin; --word) {
+                uint64_t bits {room->grid.OccupiedWord(row, word) & WordMask(word, xBegin, xEnd)};
+                if (activity) activity->visited += PopCount(bits);
+                while (bits) {
+                    int bit {HighestBit(bits)};
+                    bits &= ~(uint64_t {1} << bit);
+                    updated += SimulateCell(room->x + word * 64 + bit, y, activity);
+                }
             }
         }
     }
+
+    return updated;
 }
 
-bool SandWorker::ApplyRules(sf::Vector2i p) {
-    if (room->IsEmpty(p.x, p.y)) return false;
+uint64_t SandWorker::WordMask(int word, int xBegin, int xEnd) {
+    const int wordStart {word * 64};
+    return BitRange(std::max(xBegin, wordStart) - wordStart, std::min(xEnd, wordStart + 64) - wordStart);
+}
+
+bool SandWorker::SimulateCell(int x, int y, ChunkActivity *activity) {
+    if (ApplyRules(sf::Vector2i(x, y))) {
+        movement.KeepContainingAlive(x, y);
+        movement.KeepNeighbourAlive(x, y);
+        // The cell's element doesn't change until the step is consolidated.
+        if (activity) ++activity->updatedBy[room->grid.Id(room->ToIndex(x, y))];
+        return true;
+    }
 
-    CellState &cell {room->GetCell(p)};
+    return false;
+}
+
+bool SandWorker::ApplyRules(sf::Vector2i p) {
+    CellState cell {room->GetCell(p)};
     ConstProperties &prop {properties.constants[cell.id]};
     
     if      (  actions.PerformActions(p, cell, prop)) { return true; }  // Act on other cells.
     else if (movement.PerformMovement(p, cell, prop)) { return true; }  // Move the cell.
 
     return false;
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Telemetry.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SandWorker::UpdateActivity(uint64_t awake, int window) {
+    const uint32_t restlessChange {static_cast<uint32_t>(ChunkActivity::restlessFraction * constants::chunkWidth * constants::chunkHeight)};
+
+    for (int ci = 0; ci < static_cast<int>(room->chunks.Size()); ++ci) {
+        ChunkActivity &activity {room->chunks.GetChunk(ci).activity};
+        activity.ResetStep();
+        if (!((awake >> ci) & 1)) {
+            activity.awakeFor    = 0;
+            activity.windowSteps = 0;
+            continue;
+        }
+
+        ++activity.awakeFor;
+        if (activity.windowSteps >= static_cast<uint32_t>(window)) {
+            uint32_t census[Element::count];
+            TakeCensus(ci, census);
+            uint32_t change {0};
+            for (int e = 0; e < Element::count; ++e) {
+                change += census[e] > activity.census[e] ? census[e] - activity.census[e] : activity.census[e] - census[e];
+            }
+
+            if (change <= restlessChange) {
+                const uint32_t *most {std::max_element(std::begin(activity.updatedBy), std::end(activity.updatedBy))};
+                ++activity.restlessWindows;
+                activity.longestAwake = std::max(activity.longestAwake, activity.awakeFor);
+                activity.lastChange   = change;
+                activity.culprit      = *most ? static_cast<Element>(most - activity.updatedBy) : Element::null;
+            }
+            activity.windowSteps = 0;
+        }
+
+        // Every window starts from the chunk's census at the time.
+        if (activity.windowSteps == 0) {
+            TakeCensus(ci, activity.census);
+            std::fill(std::begin(activity.updatedBy), std::end(activity.updatedBy), 0);
+        }
+        ++activity.windowSteps;
+    }
+}
+
+void SandWorker::TakeCensus(int index, uint32_t (&census)[Element::count]) const {
+    std::fill(std::begin(census), std::end(census), 0);
+    const ChunkBounds bounds {room->chunks.GetBounds(index)};
+    for (int y = bounds.y; y < bounds.y + bounds.height; ++y) {
+        for (int x = bounds.x; x < bounds.x + bounds.width; ++x) {
+            ++census[room->grid.Id(room->ToIndex(x, y))];
+        }
+    }
+}
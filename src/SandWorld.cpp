@@ -1,19 +1,41 @@
 #include "Cell.hpp"
 #include "Constants.hpp"
 #include "Elements.hpp"
+#include "RoomCodec.hpp"
+#include "Snapshot.hpp"
 #include "SandWorld.hpp"
+#include "SandWorker.hpp"
+#include "Utility/Timing.hpp"
+#include "Utility/Trace.hpp"
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <type_traits>
+#include <utility>
+
+namespace {
+
+    constexpr int Log2(int n) {
+        return n > 1 ? 1 + Log2(n / 2) : 0;
+    }
+
+    static_assert((constants::roomWidth & (constants::roomWidth - 1)) == 0 
+        && (constants::roomHeight & (constants::roomHeight - 1)) == 0, "Room dimensions must be powers of two.");
+
+    constexpr int roomXShift {Log2(constants::roomWidth)};
+    constexpr int roomYShift {Log2(constants::roomHeight)};
+
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //  Initialisation.
 //////////////////////////////////////////////////////////////////////////////////////////
 
 SandWorld::SandWorld() : 
+    properties(),
     xMin(std::numeric_limits<int>::min()), xMax(std::numeric_limits<int>::max()),
     yMin(std::numeric_limits<int>::min()), yMax(std::numeric_limits<int>::max()),
-    properties() {
+    directory(xMin, xMax, yMin, yMax), jobs(std::make_unique<JobSystem>()), ticks(0), telemetryWindow(0), integrator(Integrator::EULER) {
     if (!InitProperties()) {
         throw std::runtime_error("Failed to initialise ElementProperties.");
     }
@@ -21,14 +43,18 @@ SandWorld::SandWorld() :
 }
 
 SandWorld::SandWorld(int _xMin, int _xMax, int _yMin, int _yMax) : 
+    properties(),
     xMin(_xMin), xMax(_xMax), yMin(_yMin), yMax(_yMax),
-    properties() {
+    directory(_xMin, _xMax, _yMin, _yMax), jobs(std::make_unique<JobSystem>()), ticks(0), telemetryWindow(0), integrator(Integrator::EULER) {
     if (!InitProperties()) {
         throw std::runtime_error("Failed to initialise ElementProperties.");
     }
     SpawnRoom(0, 0);
 }
 
+// Defined here, where SandWorker is a complete type.
+SandWorld::~SandWorld() = default;
+
 bool SandWorld::InitProperties() {
     bool success = false;
     success |= InitSand (properties);
@@ -45,36 +71,552 @@ bool SandWorld::InitProperties() {
 
 roomID_t SandWorld::SpawnRoom(int x, int y) {
     sf::Vector2i key {ToKey(x, y)};
-    if (roomsMap.count(key)) return roomsMap[key];
+    roomID_t existing {FindRoom(key)};
+    if (VALID_ROOM(existing)) return existing;
     if (key.x >= xMin && key.x < xMax && key.y >= yMin && key.y < yMax) {        
-        ElementProperties* propPtr {&properties};
-        room_ptr room {std::make_unique<SandRoom>(
-            constants::roomWidth * key.x, 
-            constants::roomHeight * key.y,
-            constants::roomWidth,
-            constants::roomHeight,
-            propPtr)};
-        roomID_t id {rooms.Insert(std::move(room))};
-        roomsMap[key] = id;
-        return id;
+        bool restored {false};
+        room_ptr room {BuildRoom(key, restored)};
+        return AddRoom(key, std::move(room), restored);
     }
     throw std::runtime_error("Failed to spawn SandRoom.");
 }
 
+SandWorld::room_ptr SandWorld::BuildRoom(sf::Vector2i key, bool &restored) {
+    ElementProperties* propPtr {&properties};
+    room_ptr room {std::make_unique<SandRoom>(
+        constants::roomWidth * key.x, 
+        constants::roomHeight * key.y,
+        constants::roomWidth,
+        constants::roomHeight,
+        propPtr)};
+    // A room that was paged out or saved in a snapshot comes back with its cells.
+    restored = Restore(*room, key);
+    return room;
+}
+
+roomID_t SandWorld::AddRoom(sf::Vector2i key, room_ptr room, bool restored) {
+    std::unique_lock<std::shared_mutex> lock {roomsMutex};
+    roomID_t existing {directory.Find(key)};
+    if (VALID_ROOM(existing)) return existing; // Another thread spawned the room first.
+    // Another thread may have paged the room out since it was checked.
+    if (!restored) restored = Restore(*room, key);
+    if (restored) Release(key);
+    SandRoom *roomPtr {room.get()};
+    roomID_t id {rooms.Insert(std::move(room))};
+    roomPtr->SetScheduleHandler([this, id] {
+        std::lock_guard<std::mutex> scheduledLock {scheduledMutex};
+        scheduled.push_back(id);
+    });
+    workers.Insert(std::make_unique<SandWorker>(id, *this, roomPtr)); // Both lists are always updated together, so the IDs match.
+    directory.Insert(key, id);
+    roomPtr->id = id;
+    LinkNeighbours(key, roomPtr);
+    // Restored rooms may have been woken up before they had a handler.
+    if (!Idle(*roomPtr)) roomPtr->Schedule();
+    return id;
+}
+
+std::vector<roomID_t> SandWorld::SpawnRooms(const std::vector<sf::Vector2i> &points) {
+    // Find the rooms that don't exist yet, only keeping one point per room.
+    std::vector<sf::Vector2i> missingKeys;
+    for (sf::Vector2i p : points) {
+        sf::Vector2i key {ToKey(p.x, p.y)};
+        if (InBounds(p) && !VALID_ROOM(ContainingRoomID(p)) 
+            && std::find(missingKeys.begin(), missingKeys.end(), key) == missingKeys.end()) {
+            missingKeys.push_back(key);
+        }
+    }
+
+    // Setting up a room is expensive, so they're built across the threads. They're added one at a time in the order
+    // of the points, so each room gets the same ID regardless of which thread built it.
+    std::vector<room_ptr> built(missingKeys.size());
+    std::unique_ptr<bool[]> restored {std::make_unique<bool[]>(missingKeys.size())};
+    jobs->ParallelFor(0, static_cast<int>(missingKeys.size()), 1, [this, &missingKeys, &built, &restored](int i) {
+        built[i] = BuildRoom(missingKeys[i], restored[i]);
+    });
+    for (size_t i = 0; i < missingKeys.size(); ++i) {
+        AddRoom(missingKeys[i], std::move(built[i]), restored[i]);
+    }
+
+    std::vector<roomID_t> ids;
+    ids.reserve(points.size());
+    for (sf::Vector2i p : points) {
+        ids.push_back(SpawnRoom(p.x, p.y));
+    }
+
+    return ids;
+}
+
 roomID_t SandWorld::RemoveRoom(int x, int y) {
-    sf::Vector2i key {x, y};
-    roomID_t id {roomsMap.at(key)}; // TODO: error-checking
+    std::unique_lock<std::shared_mutex> lock {roomsMutex};
+    roomID_t id {directory.Erase(ToKey(x, y))};
+    if (!VALID_ROOM(id)) return -1;
+
+    LinkNeighbours(ToKey(x, y), nullptr);
+    {
+        std::lock_guard<std::mutex> scheduledLock {scheduledMutex};
+        scheduled.erase(std::remove(scheduled.begin(), scheduled.end(), id), scheduled.end());
+    }
+    workers.Erase(id);
     rooms.Erase(id);
-    roomsMap.erase(key);
 
     return id;
 }
 
+void SandWorld::RequestRoom(sf::Vector2i p) {
+    if (!InBounds(p)) return;
+
+    std::lock_guard<std::mutex> lock {requestedMutex};
+    requested.push_back(ToKey(p.x, p.y));
+}
+
+void SandWorld::SpawnRequested() {
+    if (requested.empty()) return;
+
+    // Threads make their requests in any order, so the keys are sorted to give the rooms the same IDs every run.
+    std::sort(requested.begin(), requested.end(), [](sf::Vector2i a, sf::Vector2i b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    requested.erase(std::unique(requested.begin(), requested.end()), requested.end());
+
+    std::vector<sf::Vector2i> points;
+    points.reserve(requested.size());
+    for (sf::Vector2i key : requested) {
+        points.emplace_back(key.x * constants::roomWidth, key.y * constants::roomHeight);
+    }
+    requested.clear();
+    SpawnRooms(points);
+}
+
+void SandWorld::LinkNeighbours(sf::Vector2i key, SandRoom *room) {
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (dx == 0 && dy == 0) continue;
+
+            roomID_t neighbourID {directory.Find(key + sf::Vector2i {dx, dy})};
+            if (!VALID_ROOM(neighbourID)) continue;
+
+            SandRoom *neighbour {rooms[neighbourID].get()};
+            neighbour->Link(SandRoom::NeighbourSlot(-dx, -dy), room);
+            if (room) room->Link(SandRoom::NeighbourSlot(dx, dy), neighbour);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Paging.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SandWorld::EnablePaging(const std::string &path) {
+    pager = std::make_unique<RoomPager>(path);
+}
+
+void SandWorld::PageRooms(sf::Vector2i focus, int loadRadius, int unloadRadius) {
+    if (!pager) return;
+
+    const sf::Vector2i focusKey {ToKey(focus.x, focus.y)};
+    auto distance {[&focusKey](sf::Vector2i key) {
+        return std::max(std::abs(key.x - focusKey.x), std::abs(key.y - focusKey.y));
+    }};
+
+    // Rooms are only paged out once they and their neighbours have settled, so that nothing moves into them.
+    std::vector<SandRoom*> leaving;
+    for (SandWorker *worker : Workers()) {
+        SandRoom &room {worker->Room()};
+        if (!Idle(room) || distance(ToKey(room.x, room.y)) <= unloadRadius) continue;
+
+        bool settled {true};
+        for (int slot = 0; slot < SandRoom::numNeighbourSlots && settled; ++slot) {
+            SandRoom *neighbour {room.Neighbour(slot)};
+            settled = !neighbour || Idle(*neighbour);
+        }
+        if (settled) leaving.push_back(&room);
+    }
+
+    std::vector<std::vector<uint8_t>> encoded(leaving.size());
+    jobs->ParallelFor(0, static_cast<int>(leaving.size()), 1, [&leaving, &encoded](int i) {
+        encoded[i] = RoomCodec::Encode(*leaving[i]);
+    });
+    for (size_t i = 0; i < leaving.size(); ++i) {
+        const int x {leaving[i]->x}, y {leaving[i]->y};
+        pager->Store(ToKey(x, y), std::move(encoded[i]));
+        RemoveRoom(x, y);
+    }
+
+    // Rooms near the focus are reloaded, and the ones just beyond them are read ahead of time. 
+    for (int dy = -unloadRadius; dy <= unloadRadius; ++dy) {
+        for (int dx = -unloadRadius; dx <= unloadRadius; ++dx) {
+            sf::Vector2i key {focusKey.x + dx, focusKey.y + dy};
+            if (!pager->Contains(key)) continue;
+
+            if (std::max(std::abs(dx), std::abs(dy)) <= loadRadius) {
+                SpawnRoom(key.x * constants::roomWidth, key.y * constants::roomHeight);
+            } else {
+                pager->Prefetch(key);
+            }
+        }
+    }
+}
+
+std::vector<std::pair<sf::Vector2i, roomID_t>> SandWorld::FollowView(sf::Vector2i centre, sf::Vector2i size) {
+    size -= sf::Vector2i(1, 1);
+
+    // Get the position of each view corner in world space.
+    const std::vector<sf::Vector2i> corners {
+        centre - sf::Vector2i( size.x,  size.y) / 2,   // Bottom Left
+        centre - sf::Vector2i(-size.x,  size.y) / 2,   // Bottom Right
+        centre - sf::Vector2i( size.x, -size.y) / 2,   // Top Left
+        centre - sf::Vector2i(-size.x, -size.y) / 2    // Top Right
+    };
+
+    // Page out the rooms that the view has left behind, and page back in the ones it's coming up to.
+    PageRooms(centre, constants::pageInRadius, constants::pageOutRadius);
+
+    // Spawn any rooms that have come into view.
+    const std::vector<roomID_t> roomIDs {SpawnRooms(corners)};
+
+    std::vector<std::pair<sf::Vector2i, roomID_t>> rooms;
+    rooms.reserve(corners.size());
+    for (size_t i = 0; i < corners.size(); ++i) {
+        rooms.push_back(std::make_pair(corners[i], roomIDs[i]));
+    }
+
+    return rooms;
+}
+
+bool SandWorld::Restore(SandRoom &room, sf::Vector2i key) {
+    if (pager && pager->Contains(key)) {
+        RoomPager::buffer_ptr data {pager->Load(key)};
+        if (data) RoomCodec::Decode(room, *data);
+        return true;
+    }
+
+    if (snapshot && snapshot->Contains(key)) {
+        size_t size {0};
+        uint64_t awakeChunks {0};
+        const uint8_t *data {snapshot->Cells(key, size, awakeChunks)};
+        if (RoomCodec::Decode(room, data, size)) {
+            for (int ci = 0; ci < static_cast<int>(room.chunks.Size()); ++ci) {
+                if (awakeChunks >> ci & 1) room.chunks.Wake(ci);
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void SandWorld::Release(sf::Vector2i key) {
+    if (pager) pager->Forget(key);
+    if (snapshot) snapshot->Take(key);
+}
+
+bool SandWorld::Stored(sf::Vector2i key) const {
+    return (pager && pager->Contains(key)) || (snapshot && snapshot->Contains(key));
+}
+
+void SandWorld::RestoreNeighbours(const std::vector<SandWorker*> &awake) {
+    if (!(pager && pager->Size() > 0) && !(snapshot && snapshot->Remaining() > 0)) return;
+
+    // Cells in an awake room treat a missing neighbour as a wall, so stored neighbours are brought back.
+    for (SandWorker *worker : awake) {
+        SandRoom &room {worker->Room()};
+        if (Idle(room)) continue;
+
+        const sf::Vector2i roomKey {ToKey(room.x, room.y)};
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                sf::Vector2i key {roomKey.x + dx, roomKey.y + dy};
+                if (!room.Neighbour(SandRoom::NeighbourSlot(dx, dy)) && Stored(key)) {
+                    SpawnRoom(key.x * constants::roomWidth, key.y * constants::roomHeight);
+                }
+            }
+        }
+    }
+}
+
+bool SandWorld::Idle(const SandRoom &room) const {
+    return room.chunks.Asleep() && room.particles.Range() == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Snapshots.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool SandWorld::SaveSnapshot(const std::string &path) {
+    std::vector<SandWorker*> loaded {Workers()};
+    std::vector<std::vector<uint8_t>> encoded(loaded.size());
+    jobs->ParallelFor(0, static_cast<int>(loaded.size()), 1, [&loaded, &encoded](int i) {
+        encoded[i] = RoomCodec::Encode(loaded[i]->Room());
+    });
+
+    std::vector<Snapshot::Room> saved;
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        const SandRoom &room {loaded[i]->Room()};
+        saved.push_back(Snapshot::Room {ToKey(room.x, room.y), room.chunks.AwakeMask(), encoded[i].data(), encoded[i].size()});
+    }
+
+    // Rooms that aren't loaded are already encoded, so they're copied across as they are.
+    std::vector<RoomPager::buffer_ptr> paged;
+    if (pager) {
+        for (sf::Vector2i key : pager->Keys()) {
+            RoomPager::buffer_ptr data {pager->Load(key)};
+            if (!data) continue;
+            paged.push_back(data);
+            saved.push_back(Snapshot::Room {key, 0, data->data(), data->size()});
+        }
+    }
+    if (snapshot) {
+        for (sf::Vector2i key : snapshot->Keys()) {
+            if (!snapshot->Contains(key)) continue;
+            size_t size {0};
+            uint64_t awakeChunks {0};
+            const uint8_t *data {snapshot->Cells(key, size, awakeChunks)};
+            saved.push_back(Snapshot::Room {key, awakeChunks, data, size});
+        }
+    }
+
+    return Snapshot::Write(path, saved);
+}
+
+bool SandWorld::LoadSnapshot(const std::string &path) {
+    std::unique_ptr<Snapshot> loading {std::make_unique<Snapshot>(path)};
+    if (!loading->Valid()) return false;
+
+    // Replaces the whole world, including the rooms that have been paged out.
+    for (SandWorker *worker : Workers()) {
+        RemoveRoom(worker->Room().x, worker->Room().y);
+    }
+    if (pager) {
+        for (sf::Vector2i key : pager->Keys()) pager->Forget(key);
+    }
+    snapshot = std::move(loading);
+
+    // Rooms that were awake are restored straight away, in parallel. The rest are restored once they're spawned, 
+    // or once a neighbour wakes up.
+    std::vector<sf::Vector2i> points;
+    for (sf::Vector2i key : snapshot->Keys()) {
+        size_t size {0};
+        uint64_t awakeChunks {0};
+        snapshot->Cells(key, size, awakeChunks);
+        sf::Vector2i point {key.x * constants::roomWidth, key.y * constants::roomHeight};
+        if (awakeChunks && InBounds(point)) points.push_back(point);
+    }
+    SpawnRooms(points);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Simulation.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// Chunks that share a phase are only guaranteed to be apart across room borders if rooms are an even number of chunks across.
+static_assert(constants::numXChunks % 2 == 0 && constants::numYChunks % 2 == 0, "Rooms must be an even number of chunks across.");
+
+size_t SandWorld::Step(float dt) {
+    TraceScope trace {"step", "tick", static_cast<int64_t>(ticks)};
+    // Only the rooms that have woken up since the last step are simulated.
+    std::vector<SandWorker*> stepping {TakeScheduled()};
+    RestoreNeighbours(stepping);
+
+    // Particles can move between rooms and spawn new ones, so rooms begin their steps one at a time.
+    for (SandWorker *worker : stepping) {
+        worker->BeginStep(dt);
+        // Rooms that are still awake are stepped at least once more, which lets their chunks fall asleep.
+        if (!Idle(worker->Room())) worker->Room().Schedule();
+    }
+
+    // Each phase is simulated across every room at once. Requests go into per-chunk outboxes, so no two chunks
+    // write to the same queue.
+    std::atomic<size_t> updated {0};
+    std::vector<std::pair<SandWorker*, int>> batch;
+    {
+        StageTimer timer {Stage::CHUNKS};
+        for (int phase = 0; phase < 4; ++phase) {
+            TraceScope phaseTrace {"phase", "phase", phase};
+            batch.clear();
+            for (SandWorker *worker : stepping) {
+                for (int ci : worker->ActiveChunks(phase)) {
+                    batch.emplace_back(worker, ci);
+                }
+            }
+            jobs->ParallelFor(0, static_cast<int>(batch.size()), 1, [&batch, &updated](int i) {
+                updated += batch[i].first->SimulateChunk(batch[i].second);
+            });
+            // Rooms that the chunks ran into are spawned between phases, which keeps their IDs the same every run.
+            SpawnRequested();
+        }
+    }
+
+    // Explosions that went off near each other are resolved together, once per blast.
+    std::vector<sf::Vector2i> detonations;
+    for (SandWorker *worker : stepping) {
+        worker->TakeDetonations(detonations);
+    }
+    if (!detonations.empty()) {
+        StageTimer timer {Stage::BLASTS};
+        for (const Blast &blast : MergeDetonations(std::move(detonations), ActionWorker::blastMergeReach)) {
+            SandWorker *worker {Worker(ContainingRoomID(blast.origin))};
+            if (worker) worker->ResolveBlast(blast);
+        }
+    }
+
+    // Sources are visited in order of room ID and then chunk, so the queues are built in the same order every time.
+    std::vector<roomID_t> receivers;
+    {
+        TraceScope deliverTrace {"deliver outboxes"};
+        for (SandWorker *worker : stepping) {
+            receivers.push_back(worker->Room().id);
+            DeliverOutboxes(*worker, receivers);
+        }
+    }
+
+    // Rooms that weren't stepped, including ones that were spawned during the step, may have been sent requests too.
+    std::vector<SandWorker*> consolidating {Workers(std::move(receivers))};
+    jobs->ParallelFor(0, static_cast<int>(consolidating.size()), 1, [&consolidating](int i) {
+        consolidating[i]->Consolidate();
+    });
+    for (SandWorker *worker : consolidating) {
+        worker->FinishStep();
+    }
+
+    ++ticks;
+    return updated;
+}
+
+uint64_t SandWorld::Ticks() const {
+    return ticks;
+}
+
+void SandWorld::SetIntegrator(Integrator _integrator) {
+    integrator = _integrator;
+}
+
+Integrator SandWorld::ParticleIntegrator() const {
+    return integrator;
+}
+
+SandWorker *SandWorld::Worker(roomID_t id) const {
+    std::shared_lock<std::shared_mutex> lock {roomsMutex};
+    return VALID_ROOM(id) && id < workers.Range() && workers[id] ? workers[id].get() : nullptr;
+}
+
+std::vector<SandWorker*> SandWorld::Workers() const {
+    std::shared_lock<std::shared_mutex> lock {roomsMutex};
+    std::vector<SandWorker*> active;
+    for (roomID_t id = 0; id < workers.Range(); ++id) {
+        if (workers[id]) active.push_back(workers[id].get());
+    }
+
+    return active;
+}
+
+std::vector<SandWorker*> SandWorld::Workers(std::vector<roomID_t> ids) const {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::shared_lock<std::shared_mutex> lock {roomsMutex};
+    std::vector<SandWorker*> found;
+    found.reserve(ids.size());
+    for (roomID_t id : ids) {
+        if (id < workers.Range() && workers[id]) found.push_back(workers[id].get());
+    }
+
+    return found;
+}
+
+std::vector<SandWorker*> SandWorld::TakeScheduled() {
+    std::vector<roomID_t> ids;
+    {
+        std::lock_guard<std::mutex> lock {scheduledMutex};
+        ids.swap(scheduled);
+    }
+
+    std::vector<SandWorker*> taken {Workers(std::move(ids))};
+    for (SandWorker *worker : taken) {
+        worker->Room().Unschedule();
+    }
+
+    return taken;
+}
+
+void SandWorld::DeliverOutboxes(SandWorker &worker, std::vector<roomID_t> &receivers) {
+    const SandRoom &src {worker.Room()};
+    for (Outbox &outbox : worker.Outboxes()) {
+        for (int slot = 0; slot < Outbox::numSlots; ++slot) {
+            if (outbox.Empty(slot)) continue;
+
+            // Requests are only ever queued for rooms that exist, and rooms aren't removed mid-step.
+            SandRoom *dst {src.Neighbour(slot)};
+            if (dst) {
+                dst->Enqueue(outbox.moves[slot], outbox.actions[slot]);
+                if (!outbox.launches[slot].empty()) dst->AddParticles(outbox.launches[slot]);
+                receivers.push_back(dst->id);
+            }
+            outbox.Clear(slot);
+        }
+    }
+}
+
+void SandWorld::SetThreads(int numThreads) {
+    jobs = std::make_unique<JobSystem>(numThreads);
+}
+
+JobSystem &SandWorld::Jobs() const {
+    return *jobs;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Telemetry.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void SandWorld::EnableTelemetry(int window) {
+    // Counts from an earlier run are stale, so every chunk starts again.
+    if (window > 0 && telemetryWindow == 0) {
+        for (roomID_t id = 0; id < rooms.Range(); ++id) {
+            if (!rooms[id]) continue;
+            for (int ci = 0; ci < static_cast<int>(rooms[id]->chunks.Size()); ++ci) {
+                rooms[id]->chunks.GetChunk(ci).activity = ChunkActivity {};
+            }
+        }
+    }
+    telemetryWindow = std::max(window, 0);
+}
+
+int SandWorld::TelemetryWindow() const {
+    return telemetryWindow;
+}
+
+void SandWorld::ReportRestlessChunks(std::ostream &out) const {
+    std::vector<std::pair<SandRoom*, int>> restless;
+    for (roomID_t id = 0; id < rooms.Range(); ++id) {
+        if (!rooms[id]) continue;
+        for (int ci = 0; ci < static_cast<int>(rooms[id]->chunks.Size()); ++ci) {
+            if (rooms[id]->chunks.GetChunk(ci).activity.restlessWindows) restless.emplace_back(rooms[id].get(), ci);
+        }
+    }
+    std::sort(restless.begin(), restless.end(), [](const auto &a, const auto &b) {
+        return a.first->chunks.GetChunk(a.second).activity.restlessWindows 
+             > b.first->chunks.GetChunk(b.second).activity.restlessWindows;
+    });
+
+    out << restless.size() << " restless chunks (awake for " << telemetryWindow << " steps at a time with little change)\n";
+    for (const auto &[room, ci] : restless) {
+        const ChunkActivity &activity {room->chunks.GetChunk(ci).activity};
+        const ChunkBounds bounds {room->chunks.GetBounds(ci)};
+        out << "  chunk at (" << bounds.x << ", " << bounds.y << "): " 
+            << activity.restlessWindows << " restless windows, awake for up to " << activity.longestAwake << " steps, "
+            << "last change " << activity.lastChange << " cells, caused by "
+            << (activity.culprit == Element::null ? "nothing" : properties.constants[activity.culprit].name) << "\n";
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //  Access Functions.
 //////////////////////////////////////////////////////////////////////////////////////////
 
-CellState& SandWorld::GetCell(int x, int y) {
+CellState SandWorld::GetCell(int x, int y) {
     return GetContainingRoom(x, y).GetCell(x, y);
 }
 
@@ -83,11 +625,16 @@ size_t SandWorld::CellIndex(sf::Vector2i p) {
 }
 
 SandRoom& SandWorld::GetRoom(roomID_t id) {
+    std::shared_lock<std::shared_mutex> lock {roomsMutex};
     return *rooms[id].get();
 }
 
 SandRoom& SandWorld::GetRoom(sf::Vector2i key) {
-    return GetRoom(roomsMap.at(key));
+    roomID_t id {FindRoom(key)};
+    if (!VALID_ROOM(id)) {
+        throw std::out_of_range("No room exists with the given key.");
+    }
+    return GetRoom(id);
 }
 
 SandRoom& SandWorld::GetContainingRoom(sf::Vector2i p) {
@@ -161,12 +708,7 @@ roomID_t SandWorld::EmptyRoom(sf::Vector2i p) {
 }
 
 roomID_t SandWorld::ContainingRoomID(sf::Vector2i p) {
-    sf::Vector2i key {ToKey(p.x, p.y)};
-    if (roomsMap.count(key)) {
-        return roomsMap[key];
-    }
-    
-    return -1;
+    return FindRoom(ToKey(p.x, p.y));
 }
 
 bool SandWorld::InBounds(sf::Vector2i p) {
@@ -179,12 +721,18 @@ bool SandWorld::InBounds(sf::Vector2i p) {
 //////////////////////////////////////////////////////////////////////////////////////////
 
 size_t SandWorld::Size() const {
-    return rooms.Range();
+    std::shared_lock<std::shared_mutex> lock {roomsMutex};
+    return directory.Size();
+}
+
+roomID_t SandWorld::FindRoom(sf::Vector2i key) const {
+    if (directory.Dense()) return directory.Find(key);
+
+    std::shared_lock<std::shared_mutex> lock {roomsMutex};
+    return directory.Find(key);
 }
 
 sf::Vector2i SandWorld::ToKey(int x, int y) {
-    return sf::Vector2i {
-        static_cast<int>(std::floor(static_cast<float>(x) / constants::roomWidth)), 
-        static_cast<int>(std::floor(static_cast<float>(y) / constants::roomHeight))
-    };
+    // An arithmetic shift rounds towards negative infinity, which is the floor division that negative coordinates need.
+    return sf::Vector2i {x >> roomXShift, y >> roomYShift};
 }
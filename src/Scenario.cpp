@@ -0,0 +1,64 @@
+#include "Constants.hpp"
+#include "Scenario.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+Element ElementFromName(const ElementProperties &properties, const std::string &name) {
+    for (int id = 0; id < Element::count; ++id) {
+        if (properties.constants[id].name == name) return static_cast<Element>(id);
+    }
+
+    return Element::null;
+}
+
+void SpawnArea(SandWorld &world, int x, int y, int w, int h) {
+    for (int yi = y; yi < y + h + constants::roomHeight; yi += constants::roomHeight) {
+        for (int xi = x; xi < x + w + constants::roomWidth; xi += constants::roomWidth) {
+            sf::Vector2i p {std::min(xi, x + w), std::min(yi, y + h)};
+            if (world.InBounds(p)) world.SpawnRoom(p.x, p.y);
+        }
+    }
+}
+
+bool LoadScenario(SandWorld &world, const std::string &path) {
+    std::ifstream file {path};
+    if (!file) {
+        std::cerr << "Failed to open scenario: " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        std::istringstream stream {line.substr(0, line.find('#'))};
+        std::string command;
+        if (!(stream >> command)) continue; // Blank line or comment.
+
+        bool valid = false;
+        if (command == "room") {
+            int x, y;
+            if (stream >> x >> y && world.InBounds(sf::Vector2i(x, y))) {
+                world.SpawnRoom(x, y);
+                valid = true;
+            }
+        } else if (command == "fill") {
+            std::string name;
+            int x, y, w, h;
+            if (stream >> name >> x >> y >> w >> h) {
+                Element id {ElementFromName(world.properties, name)};
+                if (id != Element::null) {
+                    SpawnArea(world, x, y, w, h);
+                    world.SetArea(x, y, w, h, id);
+                    valid = true;
+                }
+            }
+        }
+
+        if (!valid) {
+            std::cerr << path << ":" << lineNumber << ": invalid scenario command: " << line << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -30,6 +30,11 @@ void Screen::RepositionView(sf::Vector2f delta) {
     setView(view);
 }
 
+void Screen::CentreView(sf::Vector2f centre) {
+    view.setCenter(tfInv * centre);
+    setView(view);
+}
+
 sf::Vector2f Screen::ToWorld(const sf::Vector2i &point) const {
     return tfInv * sf::RenderWindow::mapPixelToCoords(point);
 }
@@ -0,0 +1,159 @@
+#include "Constants.hpp"
+#include "Snapshot.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+    constexpr char magic[8] {'S', 'A', 'N', 'D', 'S', 'N', 'A', 'P'};
+
+    struct Header {
+        char        magic[8];
+        uint32_t    version;
+        uint32_t    numRooms;
+        uint32_t    roomWidth,  roomHeight;
+        uint32_t    numXChunks, numYChunks;
+        uint64_t    indexOffset;
+    };
+
+    struct IndexEntry {
+        int32_t     x, y;
+        uint64_t    awakeChunks;
+        uint64_t    offset;
+        uint64_t    size;
+    };
+
+    static_assert(sizeof(Header) == 40 && sizeof(IndexEntry) == 32, "Snapshot records must not be padded.");
+
+    template <typename T>
+    void WriteValue(std::ofstream &file, const T &value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // Writes the header, the rooms and then the index. Returns true if successful.
+    bool WriteRooms(const std::string &path, const std::vector<Snapshot::Room> &rooms) {
+        std::ofstream file {path, std::ios::binary | std::ios::trunc};
+        if (!file) return false;
+
+        uint64_t offset {sizeof(Header)};
+        std::vector<IndexEntry> index;
+        index.reserve(rooms.size());
+        for (const Snapshot::Room &room : rooms) {
+            index.push_back(IndexEntry {room.key.x, room.key.y, room.awakeChunks, offset, room.size});
+            offset += room.size;
+        }
+
+        Header header {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version      = Snapshot::version;
+        header.numRooms     = static_cast<uint32_t>(rooms.size());
+        header.roomWidth    = constants::roomWidth;
+        header.roomHeight   = constants::roomHeight;
+        header.numXChunks   = constants::numXChunks;
+        header.numYChunks   = constants::numYChunks;
+        header.indexOffset  = offset;
+
+        WriteValue(file, header);
+        for (const Snapshot::Room &room : rooms) {
+            file.write(reinterpret_cast<const char*>(room.data), room.size);
+        }
+        for (const IndexEntry &entry : index) {
+            WriteValue(file, entry);
+        }
+        file.close();
+        return static_cast<bool>(file);
+    }
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Writing.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool Snapshot::Write(const std::string &path, const std::vector<Room> &rooms) {
+    // Written beside the destination first, as the destination may be the snapshot that the world is mapping.
+    const std::string temporary {path + ".tmp"};
+    std::error_code error;
+    // Unlike std::rename, this replaces the destination on every platform.
+    if (WriteRooms(temporary, rooms)) {
+        std::filesystem::rename(temporary, path, error);
+        if (!error) return true;
+    }
+
+    std::filesystem::remove(temporary, error);
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Reading.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Snapshot::Snapshot(const std::string &path) : file(std::make_unique<MappedFile>(path)) {
+    if (!file->Valid() || file->Size() < sizeof(Header)) return;
+
+    Header header;
+    std::memcpy(&header, file->Data(), sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version
+        || header.roomWidth  != constants::roomWidth  || header.roomHeight != constants::roomHeight
+        || header.numXChunks != constants::numXChunks || header.numYChunks != constants::numYChunks
+        || header.indexOffset > file->Size()
+        || (file->Size() - header.indexOffset) / sizeof(IndexEntry) < header.numRooms) {
+        return;
+    }
+
+    entries.reserve(header.numRooms);
+    for (uint32_t i = 0; i < header.numRooms; ++i) {
+        IndexEntry entry;
+        std::memcpy(&entry, file->Data() + header.indexOffset + i * sizeof(IndexEntry), sizeof(IndexEntry));
+        if (entry.offset > header.indexOffset || entry.size > header.indexOffset - entry.offset) continue;
+
+        Entry &room {entries[sf::Vector2i {entry.x, entry.y}]};
+        room.awakeChunks    = entry.awakeChunks;
+        room.offset         = entry.offset;
+        room.size           = entry.size;
+    }
+    remaining = entries.size();
+    valid = true;
+}
+
+bool Snapshot::Valid() const {
+    return valid;
+}
+
+std::vector<sf::Vector2i> Snapshot::Keys() const {
+    std::vector<sf::Vector2i> keys;
+    keys.reserve(entries.size());
+    for (const auto &entry : entries) {
+        keys.push_back(entry.first);
+    }
+
+    return keys;
+}
+
+size_t Snapshot::Remaining() const {
+    return remaining.load(std::memory_order_relaxed);
+}
+
+bool Snapshot::Contains(sf::Vector2i key) const {
+    auto it {entries.find(key)};
+    return it != entries.end() && !it->second.taken.load(std::memory_order_acquire);
+}
+
+const uint8_t *Snapshot::Cells(sf::Vector2i key, size_t &size, uint64_t &awakeChunks) const {
+    auto it {entries.find(key)};
+    if (it == entries.end()) return nullptr;
+
+    size        = it->second.size;
+    awakeChunks = it->second.awakeChunks;
+    return file->Data() + it->second.offset;
+}
+
+bool Snapshot::Take(sf::Vector2i key) {
+    auto it {entries.find(key)};
+    if (it == entries.end() || it->second.taken.exchange(true, std::memory_order_acq_rel)) return false;
+
+    remaining--;
+    return true;
+}
@@ -0,0 +1,207 @@
+#include "Utility/JobSystem.hpp"
+#include "Utility/Trace.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+    // The job system and worker slot of the calling thread. Threads that aren't workers use slot 0.
+    thread_local const JobSystem   *currentSystem  = nullptr;
+    thread_local int                currentIndex   = 0;
+
+    uint64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+}
+
+JobSystem::JobSystem(int numThreads) : queued(0), stopping(false) {
+    numThreads = std::max(numThreads, 1);
+    SetTraceThreadName("worker 0");
+    for (int i = 0; i < numThreads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 1; i < numThreads; ++i) {
+        threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock {sleepMutex};
+        stopping = true;
+    }
+    sleep.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Submitting and waiting.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Run(TaskGroup &group, std::function<void()> fn) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    Worker &worker {*workers[ThisWorker()]};
+    {
+        std::lock_guard<std::mutex> lock {worker.mutex};
+        worker.jobs.push_back(Job {std::move(fn), &group});
+    }
+    queued++;
+
+    if (!threads.empty()) {
+        // Taking the lock ensures that a worker can't miss the notification between checking for work and sleeping.
+        { std::lock_guard<std::mutex> lock {sleepMutex}; }
+        sleep.notify_one();
+    }
+}
+
+void JobSystem::Wait(TaskGroup &group) {
+    const int index {ThisWorker()};
+    Worker &worker {*workers[index]};
+
+    uint64_t idleStart {0};
+    while (!group.Done()) {
+        Job job;
+        bool stolen;
+        if (TakeJob(index, job, stolen)) {
+            if (idleStart) {
+                worker.idleNs += NowNs() - idleStart;
+                idleStart = 0;
+            }
+            Execute(index, job, stolen);
+        } else {
+            // The remaining jobs of the group are running on other threads.
+            if (!idleStart) idleStart = NowNs();
+            std::this_thread::yield();
+        }
+    }
+
+    if (idleStart) worker.idleNs += NowNs() - idleStart;
+}
+
+void JobSystem::ParallelFor(int begin, int end, int grain, const std::function<void(int)> &fn) {
+    ParallelForRange(begin, end, grain, [&fn](int batchBegin, int batchEnd) {
+        for (int i = batchBegin; i < batchEnd; ++i) fn(i);
+    });
+}
+
+void JobSystem::ParallelForRange(int begin, int end, int grain, const std::function<void(int, int)> &fn) {
+    if (begin >= end) return;
+    grain = std::max(grain, 1);
+
+    // Nothing to gain from splitting up the range.
+    if (threads.empty() || end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+
+    TaskGroup group;
+    for (int batchBegin = begin; batchBegin < end; batchBegin += grain) {
+        int batchEnd {std::min(batchBegin + grain, end)};
+        Run(group, [&fn, batchBegin, batchEnd] { fn(batchBegin, batchEnd); });
+    }
+    Wait(group);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Statistics.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int JobSystem::Size() const {
+    return static_cast<int>(workers.size());
+}
+
+std::vector<WorkerStats> JobSystem::Stats() const {
+    std::vector<WorkerStats> stats;
+    stats.reserve(workers.size());
+    for (const std::unique_ptr<Worker> &worker : workers) {
+        stats.push_back(WorkerStats {worker->jobsRun, worker->jobsStolen, worker->idleNs});
+    }
+
+    return stats;
+}
+
+void JobSystem::ResetStats() {
+    for (std::unique_ptr<Worker> &worker : workers) {
+        worker->jobsRun     = 0;
+        worker->jobsStolen  = 0;
+        worker->idleNs      = 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//  Workers.
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::WorkerLoop(int index) {
+    currentSystem = this;
+    currentIndex  = index;
+    SetTraceThreadName("worker " + std::to_string(index));
+    Worker &worker {*workers[index]};
+
+    while (!stopping) {
+        Job job;
+        bool stolen;
+        if (TakeJob(index, job, stolen)) {
+            Execute(index, job, stolen);
+            continue;
+        }
+
+        uint64_t idleStart {NowNs()};
+        {
+            std::unique_lock<std::mutex> lock {sleepMutex};
+            sleep.wait(lock, [this] { return stopping || queued > 0; });
+        }
+        worker.idleNs += NowNs() - idleStart;
+    }
+}
+
+bool JobSystem::TakeJob(int index, Job &job, bool &stolen) {
+    if (queued == 0) return false;
+
+    // Newest job from our own deque first, as its data is most likely to still be in the cache.
+    {
+        Worker &worker {*workers[index]};
+        std::lock_guard<std::mutex> lock {worker.mutex};
+        if (!worker.jobs.empty()) {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            queued--;
+            stolen = false;
+            return true;
+        }
+    }
+
+    // Oldest job from somebody else's deque, as it's likely to be the largest.
+    const int numWorkers {Size()};
+    for (int offset = 1; offset < numWorkers; ++offset) {
+        Worker &victim {*workers[(index + offset) % numWorkers]};
+        std::lock_guard<std::mutex> lock {victim.mutex};
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued--;
+            stolen = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::Execute(int index, Job &job, bool stolen) {
+    job.fn();
+    job.group->pending.fetch_sub(1, std::memory_order_release);
+
+    Worker &worker {*workers[index]};
+    worker.jobsRun++;
+    if (stolen) worker.jobsStolen++;
+}
+
+int JobSystem::ThisWorker() const {
+    return currentSystem == this ? currentIndex : 0;
+}
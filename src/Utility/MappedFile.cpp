@@ -0,0 +1,44 @@
+#include "Utility/MappedFile.hpp"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path) : data(nullptr), size(0) {
+#ifdef MAPPED_FILE_MMAP
+    int fd {open(path.c_str(), O_RDONLY)};
+    if (fd < 0) return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *mapped {mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0)};
+        if (mapped != MAP_FAILED) {
+            data = static_cast<const uint8_t*>(mapped);
+            size = static_cast<size_t>(info.st_size);
+        }
+    }
+    // The mapping stays valid once the file is closed.
+    close(fd);
+#else
+    std::ifstream file {path, std::ios::binary | std::ios::ate};
+    if (!file) return;
+
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (file.read(reinterpret_cast<char*>(buffer.data()), buffer.size()) && !buffer.empty()) {
+        data = buffer.data();
+        size = buffer.size();
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPED_FILE_MMAP
+    if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+}
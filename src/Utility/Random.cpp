@@ -1,37 +1,69 @@
 #include "Utility/Random.hpp"
+#include "Utility/Hashes.hpp"
+#include <atomic>
 #include <random>
 
+namespace {
 
+    std::atomic<uint64_t> seed {0};
+    // Gives each thread's generator a different sequence until it's seeded with a stream.
+    std::atomic<uint64_t> numThreads {0};
 
-std::mt19937 rng(std::random_device{}());
+    thread_local Rng rng {MixBits(seed + 0x9e3779b97f4a7c15ull * ++numThreads)};
+
+}
+
+void Rng::Seed(uint64_t _seed) {
+    // Expands the seed with splitmix64, as xoshiro must not start with an all-zero state.
+    for (uint64_t &word : state) {
+        _seed += 0x9e3779b97f4a7c15ull;
+        word = MixBits(_seed);
+    }
+    bits    = 0;
+    numBits = 0;
+}
 
 void InitRng() {
-    std::srand(std::random_device{}());
-    rng.discard(10000);
+    InitRng((static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}());
+}
+
+void InitRng(uint64_t _seed) {
+    seed = _seed;
+    rng.Seed(_seed);
+}
+
+uint64_t RngSeed() {
+    return seed;
+}
+
+void SeedStream(uint64_t tick, uint64_t key, uint64_t stream) {
+    rng.Seed(MixBits(seed ^ MixBits(tick ^ MixBits(key ^ MixBits(stream)))));
+}
+
+Rng &ThreadRng() {
+    return rng;
 }
 
 int QuickRandInt(int upper) {
-    if (upper) {
-        return std::rand() % upper;
-    }
-    
-    return 0;
+    return rng.Below(upper);
 }
 
 int QuickRandRange(int a, int b) {
-    return (std::rand() / static_cast<float>(RAND_MAX)) * (b - a) + a;
+    return a + rng.Below(b - a + 1);
 }
 
 bool Probability(int percent) {
-    if (percent <= 0) return false;
-    
-    return QuickRandInt(100) < percent - 1;
+    return rng.Below(100) < percent;
+}
+
+bool CoinFlip() {
+    return rng.Bit();
 }
 
 int RandInt(int upper) {
-    return std::rand() % upper;
+    return rng.Below(upper);
 }
 
 int RandRange(int a, int b) {
-    return (std::rand() / static_cast<float>(RAND_MAX)) * (b - a) + a;
-}
\ No newline at end of file
+    return a + rng.Below(b - a + 1);
+}
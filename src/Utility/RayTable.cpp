@@ -0,0 +1,53 @@
+#include "Utility/RayTable.hpp"
+#include "Utility/Line.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+RayTable::RayTable(float radius) : extent(0) {
+    // The points on the circumference of each octant mirror the first one.
+    std::vector<sf::Vector2i> targets;
+    for (int h = 0; h <= std::round(radius * std::sqrt(0.5f)); ++h) {
+        int b {static_cast<int>(std::round(std::sqrt(radius * radius - h * h)))};
+        for (sf::Vector2i target : {sf::Vector2i( b,  h), sf::Vector2i(-b,  h), sf::Vector2i( b, -h), sf::Vector2i(-b, -h),
+                                    sf::Vector2i( h,  b), sf::Vector2i(-h,  b), sf::Vector2i( h, -b), sf::Vector2i(-h, -b)}) {
+            if (std::find(targets.begin(), targets.end(), target) == targets.end()) targets.push_back(target);
+        }
+    }
+
+    int reach {0}, extensionReach {0};
+    for (sf::Vector2i target : targets) {
+        Trace(target);
+        reach = std::max({reach, std::abs(target.x), std::abs(target.y)});
+        extensionReach = std::max(extensionReach, rays.back().extensionLimit);
+    }
+    extent = reach + extensionReach;
+}
+
+void RayTable::Trace(sf::Vector2i target) {
+    const int nx {std::abs(target.x)}, ny {std::abs(target.y)}; // The number of grid spaces to move.
+
+    Ray ray;
+    ray.target      = target;
+    ray.direction   = sf::Vector2f(target) / std::sqrt(static_cast<float>(nx * nx + ny * ny));
+
+    // The ray stops short of the target, which is where its extension starts if nothing stops it first.
+    const Supercover line {sf::Vector2i(0, 0), target};
+    ray.begin = static_cast<uint32_t>(offsets.size());
+    for (Supercover::iterator it = line.begin(), last = --line.end(); it != last; ++it) {
+        offsets.push_back(*it);
+        rings.push_back(std::max(std::abs((*it).x), std::abs((*it).y)));
+    }
+    ray.end = static_cast<uint32_t>(offsets.size());
+
+    // The extension carries on past the end of the line.
+    ray.extensionLimit = std::max(nx, ny) / 2;
+    ray.extensionBegin = static_cast<uint32_t>(offsets.size());
+    for (Supercover::iterator it = line.begin(); std::max(it.Steps().x, it.Steps().y) < ray.extensionLimit; ++it) {
+        offsets.push_back(*it);
+        rings.push_back(std::max(it.Steps().x, it.Steps().y));
+    }
+    ray.extensionEnd = static_cast<uint32_t>(offsets.size());
+
+    rays.push_back(ray);
+}
@@ -0,0 +1,29 @@
+#include "Utility/Stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+    // The smallest sample that at least the given fraction of the sorted samples are less than or equal to.
+    float Percentile(const std::vector<float> &sorted, float fraction) {
+        const size_t rank {static_cast<size_t>(std::ceil(fraction * sorted.size()))};
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+}
+
+Summary Summarise(std::vector<float> samples) {
+    Summary summary;
+    if (samples.empty()) return summary;
+
+    std::sort(samples.begin(), samples.end());
+    summary.count = samples.size();
+    summary.mean  = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    summary.min   = samples.front();
+    summary.p50   = Percentile(samples, 0.50f);
+    summary.p95   = Percentile(samples, 0.95f);
+    summary.p99   = Percentile(samples, 0.99f);
+    summary.max   = samples.back();
+    return summary;
+}
@@ -0,0 +1,157 @@
+#include "Utility/Timing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+    constexpr int numStages {static_cast<int>(Stage::count)};
+    // The number of frames that the recent summaries are taken over.
+    constexpr int windowSize {120};
+    // Frames are binned by length. The last bin holds every frame that's longer than the others cover.
+    constexpr float binWidth {0.25f};   // [milliseconds]
+    constexpr int   numBins  {400};
+
+    const char *stageNames[numStages] {
+        "particles", "chunks", "blasts", "actions", "movement", "finish", "visible_rooms", "draw"
+    };
+
+    struct Bin {
+        uint64_t frames {0};
+        double   stageMs[numStages] {};  // The total time of each stage over the frames in the bin.
+    };
+
+    uint64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // The time spent on each stage so far this frame [nanoseconds].
+    std::atomic<uint64_t> current[numStages] {};
+    uint64_t frameStart {NowNs()};
+
+    // The most recent frames, as ring buffers [milliseconds].
+    std::vector<float> recentFrames;
+    std::vector<float> recentStages[numStages];
+    int next {0};
+
+    std::vector<Bin> histogram(numBins);
+
+    float ToMs(uint64_t ns) {
+        return ns / 1e6f;
+    }
+
+    void Push(std::vector<float> &recent, float ms) {
+        if (recent.size() < windowSize) recent.push_back(ms);
+        else                            recent[next] = ms;
+    }
+
+    bool EndsWith(const std::string &string, const std::string &suffix) {
+        return string.size() >= suffix.size() && string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+}
+
+const char *StageName(Stage stage) {
+    return stageNames[static_cast<int>(stage)];
+}
+
+StageTimer::StageTimer(Stage stage) : stage(stage), start(NowNs()) {}
+
+StageTimer::~StageTimer() {
+    AddStageTime(stage, NowNs() - start);
+}
+
+void AddStageTime(Stage stage, uint64_t ns) {
+    current[static_cast<int>(stage)].fetch_add(ns, std::memory_order_relaxed);
+}
+
+void ResetFrameTimes() {
+    for (std::atomic<uint64_t> &time : current) {
+        time.store(0, std::memory_order_relaxed);
+    }
+    recentFrames.clear();
+    for (std::vector<float> &recent : recentStages) {
+        recent.clear();
+    }
+    next = 0;
+    histogram.assign(numBins, Bin {});
+    frameStart = NowNs();
+}
+
+void EndFrame() {
+    const uint64_t now {NowNs()};
+    const float frameMs {ToMs(now - frameStart)};
+    frameStart = now;
+
+    Bin &bin {histogram[std::min(static_cast<int>(frameMs / binWidth), numBins - 1)]};
+    ++bin.frames;
+    Push(recentFrames, frameMs);
+    for (int stage = 0; stage < numStages; ++stage) {
+        const float stageMs {ToMs(current[stage].exchange(0, std::memory_order_relaxed))};
+        bin.stageMs[stage] += stageMs;
+        Push(recentStages[stage], stageMs);
+    }
+    next = (next + 1) % windowSize;
+}
+
+Summary RecentStageTimes(Stage stage) {
+    return Summarise(recentStages[static_cast<int>(stage)]);
+}
+
+Summary RecentFrameTimes() {
+    return Summarise(recentFrames);
+}
+
+bool ExportFrameTimes(const std::string &path) {
+    std::ofstream file {path};
+    if (!file) {
+        std::cerr << "Failed to open frame times: " << path << "\n";
+        return false;
+    }
+
+    // Only the bins that hold frames are written. The upper bound of the last bin is left empty.
+    const bool json {EndsWith(path, ".json")};
+    if (json) {
+        file << "{\n  \"bin_ms\": " << binWidth << ",\n  \"bins\": [";
+    } else {
+        file << "min_ms,max_ms,frames";
+        for (const char *name : stageNames) {
+            file << "," << name << "_ms";
+        }
+        file << "\n";
+    }
+
+    bool first {true};
+    for (int i = 0; i < numBins; ++i) {
+        const Bin &bin {histogram[i]};
+        if (bin.frames == 0) continue;
+
+        const float lower {i * binWidth};
+        if (json) {
+            file << (first ? "\n" : ",\n") << "    {\"min_ms\": " << lower << ", \"max_ms\": ";
+            if (i < numBins - 1) file << lower + binWidth;
+            else                 file << "null";
+            file << ", \"frames\": " << bin.frames << ", \"stages_ms\": {";
+            for (int stage = 0; stage < numStages; ++stage) {
+                file << (stage ? ", " : "") << "\"" << stageNames[stage] << "\": " << bin.stageMs[stage] / bin.frames;
+            }
+            file << "}}";
+        } else {
+            file << lower << ",";
+            if (i < numBins - 1) file << lower + binWidth;
+            file << "," << bin.frames;
+            for (int stage = 0; stage < numStages; ++stage) {
+                file << "," << bin.stageMs[stage] / bin.frames;
+            }
+            file << "\n";
+        }
+        first = false;
+    }
+
+    if (json) file << "\n  ]\n}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,172 @@
+#include "Utility/Trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+    struct Event {
+        const char *name;
+        const char *argNames[2];
+        int64_t     args[2];
+        uint64_t    start, end;  // [nanoseconds]
+    };
+
+    // The events recorded by one thread. Only that thread writes to it, and the buffer is only read between frames.
+    struct ThreadBuffer {
+        // The oldest events are overwritten once the buffer is full.
+        static constexpr size_t capacity {1 << 15};
+
+        int                 tid;
+        std::string         name;
+        std::vector<Event>  events;
+        std::atomic<size_t> recorded {0};   // The number of events since the capture started.
+
+        explicit ThreadBuffer(int tid) : tid(tid), name("thread " + std::to_string(tid)), events(capacity) {}
+
+        void Push(const Event &event) {
+            const size_t i {recorded.load(std::memory_order_relaxed)};
+            events[i % capacity] = event;
+            recorded.store(i + 1, std::memory_order_release);
+        }
+    };
+
+    std::atomic<bool> tracing {false};
+
+    // Buffers are never freed, as a thread's buffer outlives the capture that it was made in.
+    std::mutex                                 buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    // Only touched between frames.
+    int         framesLeft {0};
+    std::string tracePath;
+    uint64_t    traceStart {0};
+    uint64_t    frameStart {0};
+    int64_t     frameNumber {0};
+
+    uint64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    ThreadBuffer &ThisBuffer() {
+        thread_local ThreadBuffer *buffer {nullptr};
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock {buffersMutex};
+            buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<int>(buffers.size())));
+            buffer = buffers.back().get();
+        }
+        return *buffer;
+    }
+
+    // Writes a string, escaping the characters that JSON doesn't allow.
+    void WriteString(std::ostream &out, const std::string &string) {
+        out << '"';
+        for (char c : string) {
+            if      (c == '"' || c == '\\') out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else    out << c;
+        }
+        out << '"';
+    }
+
+    bool WriteTrace(const std::string &path) {
+        std::ofstream file {path};
+        if (!file) {
+            std::cerr << "Failed to open trace: " << path << "\n";
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock {buffersMutex};
+        // Timestamps are written to the nanosecond, as the default six significant digits lose the short spans
+        // once a capture runs past a second.
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        bool first {true};
+        size_t dropped {0};
+        for (const std::unique_ptr<ThreadBuffer> &buffer : buffers) {
+            const size_t recorded {buffer->recorded.load(std::memory_order_acquire)};
+            if (recorded == 0) continue;
+
+            file << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+                 << buffer->tid << ", \"args\": {\"name\": ";
+            WriteString(file, buffer->name);
+            file << "}}";
+            first = false;
+
+            // Timestamps are in microseconds since the capture started.
+            const size_t begin {recorded > ThreadBuffer::capacity ? recorded - ThreadBuffer::capacity : 0};
+            dropped += begin;
+            for (size_t i = begin; i < recorded; ++i) {
+                const Event &event {buffer->events[i % ThreadBuffer::capacity]};
+                file << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->tid
+                     << ", \"ts\": " << (event.start - traceStart) / 1e3 << ", \"dur\": " << (event.end - event.start) / 1e3;
+                if (event.argNames[0]) {
+                    file << ", \"args\": {\"" << event.argNames[0] << "\": " << event.args[0];
+                    if (event.argNames[1]) file << ", \"" << event.argNames[1] << "\": " << event.args[1];
+                    file << "}";
+                }
+                file << "}";
+            }
+        }
+        file << "\n]}\n";
+
+        if (dropped) std::cerr << "Trace buffers overflowed, dropping the " << dropped << " oldest events\n";
+        return static_cast<bool>(file);
+    }
+
+}
+
+TraceScope::TraceScope(const char *name, const char *argName0, int64_t arg0, const char *argName1, int64_t arg1) :
+    name(name), argNames{argName0, argName1}, args{arg0, arg1},
+    start(tracing.load(std::memory_order_relaxed) ? NowNs() : 0) {}
+
+TraceScope::~TraceScope() {
+    if (start == 0) return;
+    ThisBuffer().Push(Event {name, {argNames[0], argNames[1]}, {args[0], args[1]}, start, NowNs()});
+}
+
+void SetTraceThreadName(const std::string &name) {
+    ThreadBuffer &buffer {ThisBuffer()};
+    std::lock_guard<std::mutex> lock {buffersMutex};
+    buffer.name = name;
+}
+
+void StartTrace(int frames, const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lock {buffersMutex};
+        for (std::unique_ptr<ThreadBuffer> &buffer : buffers) {
+            buffer->recorded.store(0, std::memory_order_relaxed);
+        }
+    }
+    framesLeft  = frames;
+    tracePath   = path;
+    traceStart  = NowNs();
+    frameStart  = traceStart;
+    frameNumber = 0;
+    tracing.store(frames > 0, std::memory_order_relaxed);
+}
+
+bool Tracing() {
+    return tracing.load(std::memory_order_relaxed);
+}
+
+void EndTraceFrame() {
+    if (!Tracing()) return;
+
+    // Frames are recorded on the thread that ends them, so they mark out the work of each frame.
+    const uint64_t now {NowNs()};
+    ThisBuffer().Push(Event {"frame", {"frame", nullptr}, {frameNumber++, 0}, frameStart, now});
+    frameStart = now;
+
+    if (--framesLeft > 0) return;
+    tracing.store(false, std::memory_order_relaxed);
+    if (WriteTrace(tracePath)) {
+        std::cout << "Wrote a trace of " << frameNumber << " frames to " << tracePath << "\n";
+    }
+}
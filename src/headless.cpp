@@ -0,0 +1,147 @@
+#include "Recording.hpp"
+#include "Scenario.hpp"
+#include "SandWorld.hpp"
+#include "Utility/Random.hpp"
+#include "Utility/Stats.hpp"
+#include "Utility/Timing.hpp"
+#include "Utility/Trace.hpp"
+#include <SFML/System/Clock.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Runs the simulation without a window. A scenario or snapshot is loaded into the world, which is then
+ * stepped a fixed number of times with a fixed dt as fast as possible. A recorded session can be replayed instead,
+ * which starts from an empty world and repeats the recorded view and painting with the recorded seed, dt and length.
+ */
+
+void PrintUsage(const char *name) {
+    std::printf("Usage: %s [--scenario <path> | --load <snapshot>] [--save <snapshot>] [--ticks <n>] [--dt <seconds>] [--threads <n>] [--seed <n>] [--replay <recording>] [--frame-times <csv|json>] [--chunk-report <steps>] [--trace <path>] [--page-dir <path>] [--verlet]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    std::string scenario {"./assets/scenarios/basin.txt"};
+    std::string load, save, replay, frameTimes, trace, pageDirectory;
+    long    ticks   = 1000;
+    float   dt      = 1 / 60.f;
+    int     threads = 1;
+    int     chunkWindow = 0;
+    bool    verlet  = false;
+    bool    seeded  = false;
+    uint64_t seed   = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue {i + 1 < argc};
+        if      (!std::strcmp(argv[i], "--scenario") && hasValue) { scenario = argv[++i]; }
+        else if (!std::strcmp(argv[i], "--ticks"   ) && hasValue) { ticks = std::atol(argv[++i]); }
+        else if (!std::strcmp(argv[i], "--dt"      ) && hasValue) { dt = std::atof(argv[++i]); }
+        else if (!std::strcmp(argv[i], "--threads" ) && hasValue) { threads = std::atoi(argv[++i]); }
+        else if (!std::strcmp(argv[i], "--load"    ) && hasValue) { load = argv[++i]; }
+        else if (!std::strcmp(argv[i], "--save"    ) && hasValue) { save = argv[++i]; }
+        else if (!std::strcmp(argv[i], "--seed"    ) && hasValue) { seed = std::strtoull(argv[++i], nullptr, 10); seeded = true; }
+        else if (!std::strcmp(argv[i], "--replay"  ) && hasValue) { replay = argv[++i]; }
+        else if (!std::strcmp(argv[i], "--frame-times") && hasValue) { frameTimes = argv[++i]; }
+        else if (!std::strcmp(argv[i], "--chunk-report") && hasValue) { chunkWindow = std::atoi(argv[++i]); }
+        else if (!std::strcmp(argv[i], "--trace"   ) && hasValue) { trace = argv[++i]; }
+        else if (!std::strcmp(argv[i], "--page-dir") && hasValue) { pageDirectory = argv[++i]; }
+        else if (!std::strcmp(argv[i], "--verlet"  )) { verlet = true; }
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (ticks <= 0 || dt <= 0.f) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (seeded) InitRng(seed);
+    else        InitRng();
+    SandWorld world {constants::xMinRooms, constants::xMaxRooms, constants::yMinRooms, constants::yMaxRooms};
+    world.SetThreads(threads);
+    world.SetIntegrator(verlet ? Integrator::VERLET : Integrator::EULER);
+    // Only replays move a view around, so nothing is paged out otherwise.
+    if (!pageDirectory.empty()) world.EnablePaging(pageDirectory);
+    Recording recording;
+    float loadTime {0.f};
+    if (!replay.empty()) {
+        if (!recording.Load(replay, world.properties)) return 1;
+        InitRng(recording.seed);
+        ticks    = static_cast<long>(recording.ticks);
+        dt       = recording.dt;
+        scenario = replay;
+    } else if (!load.empty()) {
+        sf::Clock loadClock;
+        if (!world.LoadSnapshot(load)) {
+            std::printf("Failed to load snapshot %s\n", load.c_str());
+            return 1;
+        }
+        loadTime = loadClock.getElapsedTime().asSeconds();
+        scenario = load;
+    } else if (!LoadScenario(world, scenario)) {
+        return 1;
+    }
+
+    world.EnableTelemetry(chunkWindow);
+
+    size_t updated {0};
+    Replayer replayer {recording};
+    std::vector<float> stepTimes;   // [milliseconds]
+    stepTimes.reserve(ticks);
+    sf::Clock clock, stepClock;
+    ResetFrameTimes();
+    // Every step is traced.
+    if (!trace.empty()) StartTrace(static_cast<int>(ticks), trace);
+    for (long tick = 0; tick < ticks; ++tick) {
+        stepClock.restart();
+        replayer.Advance(world);
+        updated += world.Step(dt);
+        stepTimes.push_back(stepClock.getElapsedTime().asMicroseconds() / 1e3f);
+        EndFrame();
+        EndTraceFrame();
+    }
+    float elapsed {clock.getElapsedTime().asSeconds()};
+    const Summary steps {Summarise(stepTimes)};
+
+    if (!frameTimes.empty() && !ExportFrameTimes(frameTimes)) return 1;
+    if (!save.empty() && !world.SaveSnapshot(save)) {
+        std::printf("Failed to save snapshot %s\n", save.c_str());
+        return 1;
+    }
+
+    std::printf("scenario:           %s\n",     scenario.c_str());
+    std::printf("rooms:              %zu\n",    world.Size());
+    std::printf("threads:            %d\n",     threads);
+    std::printf("seed:               %llu\n",   static_cast<unsigned long long>(RngSeed()));
+    std::printf("ticks:              %ld\n",    ticks);
+    std::printf("elapsed:            %.3f s\n", elapsed);
+    std::printf("ticks/sec:          %.1f\n",   ticks / elapsed);
+    std::printf("cells updated/sec:  %.0f\n",   updated / elapsed);
+    std::printf("step mean:          %.3f ms\n", steps.mean);
+    std::printf("step p50/p95/p99:   %.3f / %.3f / %.3f ms\n", steps.p50, steps.p95, steps.p99);
+    std::printf("step max:           %.3f ms\n", steps.max);
+    if (!load.empty()) {
+        std::printf("snapshot load:      %.3f ms\n", loadTime * 1e3f);
+    }
+
+    // Shows how well the work was balanced across the threads.
+    std::vector<WorkerStats> stats {world.Jobs().Stats()};
+    for (size_t i = 0; i < stats.size() && threads > 1; ++i) {
+        std::printf("worker %2zu:          %llu jobs, %llu stolen, %.3f s idle\n", i,
+            static_cast<unsigned long long>(stats[i].jobsRun), 
+            static_cast<unsigned long long>(stats[i].jobsStolen), 
+            stats[i].idleNs / 1e9);
+    }
+
+    if (chunkWindow > 0) {
+        std::fflush(stdout);
+        world.ReportRestlessChunks(std::cout);
+    }
+
+    return 0;
+}
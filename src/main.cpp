@@ -1,13 +1,73 @@
+#include "Elements/ElementProperties.hpp"
 #include "SandGame.hpp"
 #include "Utility/Random.hpp"
 #include <SFML/Graphics.hpp>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+
+int main(int argc, char *argv[]) {
+    int threads = 1;
+    int chunkWindow = 0;
+    int traceFrames = 0;
+    bool verlet {false};
+    std::string pageDirectory, record, replay, frameTimes;
+    bool seeded {false};
+    uint64_t seed {0};
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--page-dir") && i + 1 < argc) {
+            pageDirectory = argv[++i];
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+            seeded = true;
+        } else if (!std::strcmp(argv[i], "--record") && i + 1 < argc) {
+            record = argv[++i];
+        } else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc) {
+            replay = argv[++i];
+        } else if (!std::strcmp(argv[i], "--frame-times") && i + 1 < argc) {
+            frameTimes = argv[++i];
+        } else if (!std::strcmp(argv[i], "--chunk-report") && i + 1 < argc) {
+            chunkWindow = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) {
+            traceFrames = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--verlet")) {
+            verlet = true;
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--threads <n>] [--page-dir <path>] [--seed <n>] [--record <path> | --replay <path>] [--frame-times <csv|json>] [--chunk-report <steps>] [--trace <frames>] [--verlet]\n";
+            return 1;
+        }
+    }
+
+    // The simulation core doesn't link against the graphics module, so element textures are decoded here.
+    SetTextureLoader([](const std::string &path, Texture &texture) {
+        sf::Image image;
+        if (!image.loadFromFile(path) || image.getSize().x == 0 || image.getSize().y == 0) return false;
+
+        texture.width  = image.getSize().x;
+        texture.height = image.getSize().y;
+        texture.pixels.resize(static_cast<size_t>(texture.width) * texture.height);
+        // Both are stored as RGBA bytes, row by row from the top left.
+        std::memcpy(texture.pixels.data(), image.getPixelsPtr(), texture.pixels.size() * sizeof(Colour));
+        return true;
+    });
+
+    if (seeded) InitRng(seed);
+    else        InitRng();
+    SandGame game {threads, pageDirectory, verlet ? Integrator::VERLET : Integrator::EULER};
+    // Replays use the seed they were recorded with.
+    if (!replay.empty()) {
+        if (!game.Replay(replay)) return 1;
+    } else if (!record.empty()) {
+        game.Record(record);
+    }
+    if (!frameTimes.empty()) game.SaveFrameTimes(frameTimes);
+    if (chunkWindow > 0) game.TrackChunks(chunkWindow);
+    if (traceFrames > 0) game.Trace(traceFrames);
 
-int main() {
-    InitRng();
-    SandGame game;
-    
     game.Run();
 
     return 0;
-}
\ No newline at end of file
+}